@@ -121,33 +121,38 @@ void mt19937_init_by_array64(unsigned long long init_key[],
     mt[0] = 1ULL << 63; /* MSB is 1; assuring non-zero initial array */ 
 }
 
-/* generates a random number on [0, 2^64-1]-interval */
-unsigned long long mt19937_int64(void)
+/* generates NN words at one time */
+static void mt19937_next_state(void)
 {
     int i;
     unsigned long long x;
     static unsigned long long mag01[2]={0ULL, MATRIX_A};
 
-    if (mti >= NN) { /* generate NN words at one time */
+    /* if mt19937_init() has not been called, */
+    /* a default initial seed is used     */
+    if (mti == NN+1) 
+        mt19937_init(5489ULL); 
 
-        /* if mt19937_init() has not been called, */
-        /* a default initial seed is used     */
-        if (mti == NN+1) 
-            mt19937_init(5489ULL); 
+    for (i=0;i<NN-MM;i++) {
+        x = (mt[i]&UM)|(mt[i+1]&LM);
+        mt[i] = mt[i+MM] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
+    }
+    for (;i<NN-1;i++) {
+        x = (mt[i]&UM)|(mt[i+1]&LM);
+        mt[i] = mt[i+(MM-NN)] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
+    }
+    x = (mt[NN-1]&UM)|(mt[0]&LM);
+    mt[NN-1] = mt[MM-1] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
 
-        for (i=0;i<NN-MM;i++) {
-            x = (mt[i]&UM)|(mt[i+1]&LM);
-            mt[i] = mt[i+MM] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
-        }
-        for (;i<NN-1;i++) {
-            x = (mt[i]&UM)|(mt[i+1]&LM);
-            mt[i] = mt[i+(MM-NN)] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
-        }
-        x = (mt[NN-1]&UM)|(mt[0]&LM);
-        mt[NN-1] = mt[MM-1] ^ (x>>1) ^ mag01[(int)(x&1ULL)];
+    mti = 0;
+}
 
-        mti = 0;
-    }
+/* generates a random number on [0, 2^64-1]-interval */
+unsigned long long mt19937_int64(void)
+{
+    unsigned long long x;
+
+    if (mti >= NN) mt19937_next_state();
   
     x = mt[mti++];
 
@@ -159,6 +164,30 @@ unsigned long long mt19937_int64(void)
     return x;
 }
 
+/* fills out[] with n numbers on [0, 2^64-1]-interval; */
+/* gives the same sequence as n calls of mt19937_int64(), */
+/* but tempers whole runs of the state vector at once  */
+void mt19937_fill_int64(unsigned long long out[], unsigned long long n)
+{
+    unsigned long long i, k;
+    while (n > 0) {
+        if (mti >= NN) mt19937_next_state();
+        k = (unsigned long long)(NN-mti);
+        if (k > n) k = n;
+        for (i=0; i<k; i++) {
+            unsigned long long x = mt[mti+i];
+            x ^= (x >> 29) & 0x5555555555555555ULL;
+            x ^= (x << 17) & 0x71D67FFFEDA60000ULL;
+            x ^= (x << 37) & 0xFFF7EEE000000000ULL;
+            x ^= (x >> 43);
+            out[i] = x;
+        }
+        mti += (int)k;
+        out += k;
+        n -= k;
+    }
+}
+
 /* generates a random number on [0, 2^63-1]-interval */
 long long mt19937_int63(void)
 {
@@ -83,6 +83,8 @@ void mt19937_init_by_array64(unsigned long long init_key[],
 /* generates a random number on [0, 2^64-1]-interval */
 unsigned long long mt19937_int64(void);
 
+void mt19937_fill_int64(unsigned long long out[], unsigned long long n);
+
 
 /* generates a random number on [0, 2^63-1]-interval */
 long long mt19937_int63(void);
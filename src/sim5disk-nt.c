@@ -14,8 +14,11 @@
 //! Provides routines for the radial structure of a relativistic thin disk model as given 
 //! by Novikov & Thorne (1973) and Page & Thorne (1974).
 //! 
-//! NOTE: This unit uses some static variables to store some persistent information and due to that 
-//! it is NOT thread-safe. For the same reasons, the routines declared here are not available to CUDA.
+//! All parameters of a disk model are kept in a context structure (sim5disknt) that is passed
+//! to the `disknt_*` routines, so that several disk models can be used at the same time and from
+//! different threads. The older `disk_nt_*` interface is kept for compatibility; it operates on
+//! a single default context and as such it is NOT thread-safe. The routines declared here are 
+//! not available to CUDA.
 
 
 
@@ -23,18 +26,13 @@
 #ifndef CUDA
 
 
-// TODO: these should be made thread local
-static float disk_nt_bh_mass    = 10.0;
-static float disk_nt_bh_spin    = 0.0;
-static float disk_nt_disk_mdot  = 0.1;
-static float disk_nt_disk_rms   = 6.0;
-static float disk_nt_disk_alpha = 0.1;
-static int   disk_nt_options    = 0;
-
+//-----------------------------------------------------------------
+// disk model with context
+//-----------------------------------------------------------------
 
 
 DEVICEFUNC
-int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int options)
+int disknt_setup(sim5disknt* d, double M, double a, double mdot_or_L, double alpha, int options)
 //! Sets up a relativistic (Novikov-Thorne) model of a thin disk.
 //! The disk can be set up using either mass accretion rate (mdot) or by specifying its luminosity (L). 
 //! Mass accretion rate is passed as a ratio between the actual mass supply rate in grams per second to 
@@ -44,6 +42,9 @@ int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int option
 //! that the integrated disk luminosity matches the given value in ergs/sec relative to the Eddington 
 //! luminosity for the given black-hole mass.
 //!
+//! The routine also precomputes spin-dependent constants that are used by disknt_flux() and disknt_sigma().
+//!
+//! @param d disk context (output)
 //! @param M mass of the central BH [M_sun]
 //! @param a spin of the central BH [0..1]
 //! @param mdot_or_L mass accretion rate (default) or luminosity (both in eddington units; see sim5const.h)
@@ -53,25 +54,21 @@ int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int option
 //!
 //! @result A status code (currently returns always zero)
 {
-    disk_nt_bh_mass    = M;
-    disk_nt_bh_spin    = a;
-    disk_nt_disk_rms   = disk_nt_r_min();
-    disk_nt_disk_alpha = alpha;
-    disk_nt_options    = options;
-    if (disk_nt_options & DISK_NT_OPTION_LUMINOSITY) {
-        DEVICEFUNC double disk_nt_find_mdot_for_luminosity(double L0);
-        disk_nt_disk_mdot = disk_nt_find_mdot_for_luminosity(mdot_or_L);
-        //fprintf(
-        //    stderr, "(disk-nt) final mdot for L=%.5f: mdot=%.5f (%.6e 10^18 g/s)\n", 
-        //    mdot_or_L, disk_nt_disk_mdot, disk_nt_disk_mdot*disk_nt_bh_mass*Mdot_Edd/1e18
-        //);
+    d->M       = M;
+    d->a       = a;
+    d->alpha   = alpha;
+    d->options = options;
+    d->rms     = disknt_r_min(d);
+    d->x0      = sqrt(d->rms);
+    d->x1      = +2.*cos(1./3.*acos(a)-M_PI/3.);
+    d->x2      = +2.*cos(1./3.*acos(a)+M_PI/3.);
+    d->x3      = -2.*cos(1./3.*acos(a));
+    if (options & DISK_NT_OPTION_LUMINOSITY) {
+        // luminosity is linear in mdot
+        d->mdot = mdot_or_L / disknt_lumi_per_mdot(a);
     }
     else {
-        disk_nt_disk_mdot = mdot_or_L;
-        //fprintf(
-        //    stderr, "(disk-nt) mdot set to %.5f: (%.6e 10^18 g/s; lum=%.5f)\n", 
-        //    disk_nt_disk_mdot, disk_nt_disk_mdot*disk_nt_bh_mass*Mdot_Edd/1e18, disk_nt_lumi()
-        //);
+        d->mdot = mdot_or_L;
     }
     return 0;
 }
@@ -79,23 +76,16 @@ int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int option
 
 
 DEVICEFUNC
-void disk_nt_done()
-//! Finalize the disk model.
-//! Cleans up and frees necessary memory.
-{
-}
-
-
-
-DEVICEFUNC
-double disk_nt_r_min()
+double disknt_r_min(sim5disknt* d)
 //! Minimal radius of the disk (disk inner edge).
 //! Provides minimal value for radius for which the functions provide valid results. 
 //! For NT disk, this corresponds to the radius of the marginally stable orbit (r_ms, also known as ISCO), where there is zero torque in the fluid.
 //!
+//! @param d disk context
+//!
 //! @result Radius of disk inner edge [GM/c2]
 {
-    double a = disk_nt_bh_spin;
+    double a = d->a;
     double z1,z2,r0;
     double sga = (a>=0.0) ? +1. : -1.;
     z1 = 1.+pow(1.-a*a, 1./3.)*(pow(1.+a, 1./3.)+pow(1.-a, 1./3.));
@@ -107,25 +97,22 @@ double disk_nt_r_min()
 
 
 DEVICEFUNC
-double disk_nt_flux(double r)
+double disknt_flux(sim5disknt* d, double r)
 //! Local flux from one side of the disk.
 //! Provides radial radiation flux dependence for Novikov-Thorne accretion disk.
 //! Formulae are based on Page&Thorne(1974) http://adsabs.harvard.edu/abs/1974ApJ...191..499P
 //!
 //! Note the retuned flux is local flux, i.e. flux measured by an observer that is at rest with respect to the fluid.
 //!
+//! @param d disk context
 //! @param r radius of emission [GM/c2]
 //!
 //! @result Total outgoing flux from unit area on one side of the disk [erg cm-2 s-1]. 
 {
-    if (r <= disk_nt_disk_rms) return 0.0;
-    double a = disk_nt_bh_spin;
+    if (r <= d->rms) return 0.0;
+    double a = d->a;
     double x=sqrt(r);
-    double x0,x1,x2,x3;
-    x0=sqrt(disk_nt_disk_rms);
-    x1=+2.*cos(1./3.*acos(a)-M_PI/3.);
-    x2=+2.*cos(1./3.*acos(a)+M_PI/3.);
-    x3=-2.*cos(1./3.*acos(a));
+    double x0=d->x0, x1=d->x1, x2=d->x2, x3=d->x3;
     double f0,f1,f2,f3,F;
     // PT74 (eq.15n)
     f0=x-x0-1.5*a*log(x/x0);
@@ -142,14 +129,38 @@ double disk_nt_flux(double r)
     // the result shall be adjusted for actuall BH mass and acc rate following the scaling
     // F~mdot/m, where m=M/M_sun and mdot=Mdot/(M/M_sun*Mdot_Edd)
 
-    return 9.1721376255e+28 * F * disk_nt_disk_mdot/disk_nt_bh_mass; // [erg cm^-2 s^-1]
+    return 9.1721376255e+28 * F * d->mdot/d->M; // [erg cm^-2 s^-1]
+}
+
+
+
+//! \cond SKIP
+DEVICEFUNC static
+double disknt_lumi_func(double log_r, void* ctx)
+// integrand of disknt_lumi_integrate(): dL/d(log r)
+{
+    sim5disknt* d = (sim5disknt*)ctx;
+    double r = exp(log_r);
+    // calculate U_t
+    double gtt = -1. + 2./r;
+    double gtf = -2.*d->a/r;
+    double gff = sqr(r) + sqr(d->a) + 2.*sqr(d->a)/r;
+    double Omega = 1./(d->a + pow(r,1.5));
+    double U_t = sqrt(-1.0/(gtt + 2.*Omega*gtf + sqr(Omega)*gff)) * (gtt + Omega*gtf);
+    double F = disknt_flux(d, r);
+    // dL = 2pi*r*F(r) dr, extra r comes from log integration
+    return 2.*M_PI*r*2.0*(-U_t)*F * r;
 }
+//! \endcond
 
 
 
 DEVICEFUNC
-double disk_nt_lumi()
-//! Total disk luminosity.
+double disknt_lumi_integrate(sim5disknt* d)
+//! Total disk luminosity by direct integration.
+//! This is the reference implementation of disknt_lumi(), which evaluates the integral numerically 
+//! on each call. It is used to build the luminosity table and as a fallback for spins outside 
+//! of the table range.
 //! Luminosity is obtained by integrating local flux over the surface area of the disk (both sides)
 //! going into the whole sky (4pi solid angle). 
 //! The integration makes a proper transformation of the flux from local to coordinate frame, but 
@@ -157,70 +168,182 @@ double disk_nt_lumi()
 //!
 //! \f[L = 2 * 2\pi \int F(r) (-U_t) r dr\f]
 //!
-//! @result Total disk luminosity of both surfaces [erg s-1]
+//! @param d disk context
+//!
+//! @result Total disk luminosity of both surfaces [L_Edd]
 {
     const float disk_rmax = 1e5;
 
     // integrate disk luminosity from r_ms to disk_rmax rg
     // - the integration uses 'logarithmic rule': L = \int f(x) dx \int f(x)*x d(log(x))
+    // (lower tolerance leads to spurious early convergence for some spins)
+    double L = integrate_simpson_ctx(disknt_lumi_func, d, log(d->rms), log(disk_rmax), 1e-7);
+
+    // fix units to erg/s
+    L *= sqr(d->M*grav_radius);
+
+    return L/(L_Edd*d->M);
+}
+
+
+
+//! \cond SKIP
+// table of luminosity per unit accretion rate as a function of spin;
+// the table is uniform in r_ms (where the efficiency is smooth) and spans spins from -DISK_NT_LUMI_TABLE_AMAX to +DISK_NT_LUMI_TABLE_AMAX
+#define DISK_NT_LUMI_TABLE_N        256
+#define DISK_NT_LUMI_TABLE_AMAX     0.999
+
+static double* disk_nt_lumi_table = NULL;
+
+
+// radius of marginally stable orbit (without the offset that is used by disknt_r_min())
+DEVICEFUNC INLINE
+static double disknt_rms(double a)
+{
+    sim5disknt d;
+    d.a = a;
+    return disknt_r_min(&d) - 1e-3;
+}
+
+
+// spin that corresponds to given r_ms (inverse of disknt_rms())
+DEVICEFUNC INLINE
+static double disknt_rms_spin(double rms)
+{
+    return sqrt(rms)*(4.-sqrt(3.*rms-2.))/3.;
+}
 
-    double func_luminosity(double log_r)
-    {
-        double r = exp(log_r);
-        // calculate U_t
-        double gtt = -1. + 2./r;
-        double gtf = -2.*disk_nt_bh_spin/r;
-        double gff = sqr(r) + sqr(disk_nt_bh_spin) + 2.*sqr(disk_nt_bh_spin)/r;
-        double Omega = 1./(disk_nt_bh_spin + pow(r,1.5));
-        double U_t = sqrt(-1.0/(gtt + 2.*Omega*gtf + sqr(Omega)*gff)) * (gtt + Omega*gtf);
-        double F = disk_nt_flux(r);
-        // dL = 2pi*r*F(r) dr, extra r comes from log integration
-        return 2.*M_PI*r*2.0*(-U_t)*F * r;
+
+// builds the table (once per process); concurrent callers may build it in parallel, 
+// but only one copy is published and the others are discarded
+DEVICEFUNC
+static double* disknt_lumi_table()
+{
+    double* table = __atomic_load_n(&disk_nt_lumi_table, __ATOMIC_ACQUIRE);
+    if (table) return table;
+
+    int i;
+    const double r1 = disknt_rms(+DISK_NT_LUMI_TABLE_AMAX);
+    const double r2 = disknt_rms(-DISK_NT_LUMI_TABLE_AMAX);
+    double* new_table = (double*)malloc((DISK_NT_LUMI_TABLE_N+2)*sizeof(double));
+    if (!new_table) return NULL;
+
+    // table header: r_ms of the first node and inverse step
+    new_table[0] = r1;
+    new_table[1] = (double)(DISK_NT_LUMI_TABLE_N-1)/(r2-r1);
+    for (i=0; i<DISK_NT_LUMI_TABLE_N; i++) {
+        sim5disknt d;
+        double rms = r1 + (r2-r1)*(double)(i)/(double)(DISK_NT_LUMI_TABLE_N-1);
+        disknt_setup(&d, 1.0, disknt_rms_spin(rms), 1.0, 0.1, 0);
+        new_table[2+i] = disknt_lumi_integrate(&d);
     }
 
-    double L = integrate_simpson(func_luminosity, log(disk_nt_disk_rms), log(disk_rmax), 1e-5);
+    table = NULL;
+    if (!__atomic_compare_exchange_n(&disk_nt_lumi_table, &table, new_table, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // other thread has been faster
+        free(new_table);
+        return table;
+    }
+    return new_table;
+}
+//! \endcond
 
-    // fix units to erg/s
-    L *= sqr(disk_nt_bh_mass*grav_radius);
 
-    return L/(L_Edd*disk_nt_bh_mass);
+
+DEVICEFUNC
+double disknt_lumi_per_mdot(double a)
+//! Disk luminosity per unit accretion rate.
+//! Gives the luminosity of the disk in Eddington units for a unit accretion rate (in Eddington units),
+//! i.e. the radiative efficiency of the disk relative to the one that defines the Eddington accretion rate.
+//! As the luminosity scales linearly with mdot and it is independent of BH mass and alpha, 
+//! this is a function of spin only.
+//!
+//! The value is interpolated from a table that is computed on the first call (the table 
+//! is built once per process and the routine is thread-safe). For spins outside of 
+//! the table range (|a|>0.999) the luminosity is integrated directly.
+//!
+//! @param a spin of the central BH
+//!
+//! @result Luminosity per unit accretion rate [L_Edd/Mdot_Edd].
+{
+    double* table = (fabs(a) <= DISK_NT_LUMI_TABLE_AMAX) ? disknt_lumi_table() : NULL;
+    if (!table) {
+        sim5disknt d;
+        disknt_setup(&d, 1.0, a, 1.0, 0.1, 0);
+        return disknt_lumi_integrate(&d);
+    }
+
+    // 4-point Lagrange interpolation in r_ms
+    double x = (disknt_rms(a)-table[0])*table[1];
+    int i = (int)x - 1;
+    if (i < 0) i = 0;
+    if (i > DISK_NT_LUMI_TABLE_N-4) i = DISK_NT_LUMI_TABLE_N-4;
+    double t  = x - (double)(i);
+    double* y = table + 2 + i;
+    return
+        - y[0]*(t-1.)*(t-2.)*(t-3.)/6.
+        + y[1]*t*(t-2.)*(t-3.)/2.
+        - y[2]*t*(t-1.)*(t-3.)/2.
+        + y[3]*t*(t-1.)*(t-2.)/6.;
 }
 
 
 
 DEVICEFUNC
-double disk_nt_mdot()
+double disknt_lumi(sim5disknt* d)
+//! Total disk luminosity.
+//! Luminosity is obtained by integrating local flux over the surface area of the disk (both sides)
+//! going into the whole sky (4pi solid angle). 
+//! The integration makes a proper transformation of the flux from local to coordinate frame, but 
+//! it ignores other relativistic effects, e.g. light bending.
+//!
+//! \f[L = 2 * 2\pi \int F(r) (-U_t) r dr\f]
+//!
+//! The luminosity is linear in mdot, so it is evaluated as `mdot*disknt_lumi_per_mdot(a)` 
+//! using a precomputed table (see disknt_lumi_per_mdot()). 
+//! Use disknt_lumi_integrate() to evaluate the integral directly.
+//!
+//! @param d disk context
+//!
+//! @result Total disk luminosity of both surfaces [L_Edd]
+{
+    return d->mdot * disknt_lumi_per_mdot(d->a);
+}
+
+
+
+DEVICEFUNC
+double disknt_mdot(sim5disknt* d)
 //! Mass accretion rate.
-//! Returns mass accretion rate in Eddington units. See `disk_nt_setup()` for details.
+//! Returns mass accretion rate in Eddington units. See `disknt_setup()` for details.
+//!
+//! @param d disk context
 //!
 //! @result Mass accretion rate in Eddington units.
 {
-    return disk_nt_disk_mdot;
+    return d->mdot;
 }
 
 
 
 DEVICEFUNC
-double disk_nt_sigma(double r)
+double disknt_sigma(sim5disknt* d, double r)
 //! Column density.
 //! Returns midplane column density of the fluid, i.e. the fluid density integrated from midplane to the disk surface, 
 //! at a given radius for the first two zones according to formulae from Chandrasekhar's book.
 //!
 //! \f[ \Sigma = \int_0^H \rho dz \f]
 //!
+//! @param d disk context
 //! @param r radius (measured in equatorial plane) [rg]
 //!
 //! @result Midplane column density in [g/cm2].
 {
-    if (r < disk_nt_disk_rms) return 0.0;
-    double a = disk_nt_bh_spin;
+    if (r < d->rms) return 0.0;
+    double a = d->a;
 
     double x=sqrt(r);
-    double x0,x1,x2,x3;
-    x0=sqrt(disk_nt_disk_rms);
-    x1=+2.*cos(1./3.*acos(a)-M_PI/3.);
-    x2=+2.*cos(1./3.*acos(a)+M_PI/3.);
-    x3=-2.*cos(1./3.*acos(a));
+    double x0=d->x0, x1=d->x1, x2=d->x2, x3=d->x3;
 
     double xA, xB, xC, xD, xE, xL;
     xA = 1. + sqr(a)/sqr(r) + 2.*sqr(a)/sqr3(r);
@@ -236,15 +359,15 @@ double disk_nt_sigma(double r)
     f3=3.*(x3-a)*(x3-a)/(x3*(x3-x2)*(x3-x1))*log((x-x3)/(x0-x3));
     xL = (1.+a/(x*x*x))/sqrt(1.-3./(x*x)+2.*a/(x*x*x))/x * (f0-f1-f2-f3);
 
-    double xMdot = disk_nt_disk_mdot*disk_nt_bh_mass*Mdot_Edd/1e17;
-    double r_im = 40.*(pow(disk_nt_disk_alpha,2./21.)/pow(disk_nt_bh_mass/3.,2./3.)*pow(xMdot,16./20.)) * pow(xA,20./21.) *
+    double xMdot = d->mdot*d->M*Mdot_Edd/1e17;
+    double r_im = 40.*(pow(d->alpha,2./21.)/pow(d->M/3.,2./3.)*pow(xMdot,16./20.)) * pow(xA,20./21.) *
     pow(xB,-36./21.) * pow(xD,-8./21.) * pow(xE,-10./21.) * pow(xL,16./21.);
 
     double Sigma;
     if (r < r_im)
-        Sigma = 20. * (disk_nt_bh_mass/3.)/xMdot/disk_nt_disk_alpha * sqrt(r*r*r) * 1./(xA*xA) * pow(xB,3.) * sqrt(xC) * xE * 1./xL;
+        Sigma = 20. * (d->M/3.)/xMdot/d->alpha * sqrt(r*r*r) * 1./(xA*xA) * pow(xB,3.) * sqrt(xC) * xE * 1./xL;
     else {
-        Sigma = 5e4 * pow(disk_nt_bh_mass/3.,-2./5.)*pow(xMdot,3./5.)*pow(disk_nt_disk_alpha,-4./5.) * pow(r,-3./5.) * pow(xB,-4./5.) * sqrt(xC) * pow(xD,-4./5.) * pow(xL,3./5.);
+        Sigma = 5e4 * pow(d->M/3.,-2./5.)*pow(xMdot,3./5.)*pow(d->alpha,-4./5.) * pow(r,-3./5.) * pow(xB,-4./5.) * sqrt(xC) * pow(xD,-4./5.) * pow(xL,3./5.);
     }
 
     return Sigma;
@@ -253,27 +376,29 @@ double disk_nt_sigma(double r)
 
 
 DEVICEFUNC
-double disk_nt_ell(double r)
+double disknt_ell(sim5disknt* d, double r)
 //! Specific angular momentum.
 //! Returns specific angular momentum of the fluid at given radius. 
 //!
+//! @param d disk context
 //! @param r radius (measured in equatorial plane) [rg]
 //!
 //! @result Specific angular momentum in [g.u.].
 {
-    double a = disk_nt_bh_spin;
-    r = fmax(disk_nt_disk_rms, r);
+    double a = d->a;
+    r = fmax(d->rms, r);
     return (r*r-2.*a*sqrt(r)+a*a) / (sqrt(r)*r-2.*sqrt(r)+a);
 }
 
 
 
 DEVICEFUNC
-double disk_nt_vr(double r)
+double disknt_vr(sim5disknt* d, double r)
 //! Radial velocity.
 //! Returns bulk radial velocity of the fluid at given radius, which in case
 //! of thin disks is always zero.
 //!
+//! @param d disk context
 //! @param r radius (measured in equatorial plane) [rg]
 //!
 //! @result Radial velocity in [speed_of_light].
@@ -284,12 +409,13 @@ double disk_nt_vr(double r)
 
 
 DEVICEFUNC
-double disk_nt_h(double r)
+double disknt_h(sim5disknt* d, double r)
 //! Surface height.
 //! Returns the scale-height of the surface of the disk (a measure of the effective photosphere location) above midplane at given radius. 
 //! In thin disks, this is always zero. In fact, the height of the disk should be where the equation of hydrostatic
 //! equilibrium gives it, but the thin disk approximation assumes the disk razor thin, hence H=0.
 //!
+//! @param d disk context
 //! @param r radius (measured in equatorial plane) [rg]
 //!
 //! @result Scale-height [rg].
@@ -300,11 +426,12 @@ double disk_nt_h(double r)
 
 
 DEVICEFUNC
-double disk_nt_dhdr(double r)
+double disknt_dhdr(sim5disknt* d, double r)
 //! Derivative of surface height.
 //! Returns surface profile as derivative \f$dH/dR\f$ of its height above midplane at given radius. 
 //! For thin disks, this is always zero.
 //!
+//! @param d disk context
 //! @param r radius (measured in equatorial plane) [rg]
 //!
 //! @result Derivative of surface height.
@@ -315,12 +442,13 @@ double disk_nt_dhdr(double r)
 
 
 DEVICEFUNC
-void disk_nt_dump(char* filename)
+void disknt_dump(sim5disknt* d, char* filename)
 //! Prints the disk structure as a function of radius.
 //! The function prints the profile of all quantities as a function of radius 
 //! from r_ms to some outer radius (~2000 rg). It prints to a file identified by its path (overwrites existing) and 
 //! if that is empty it prints to STDOUT.
 //!
+//! @param d disk context
 //! @param filename Path to a file that should be written. If NULL then it prints to STDOUT. 
 {
     FILE* stream = stdout;
@@ -334,29 +462,29 @@ void disk_nt_dump(char* filename)
     const float disk_rmax = 2000.;
     fprintf(stream, "# (sim5disk-nt) dump\n");
     fprintf(stream, "#-------------------------------------------\n");
-    fprintf(stream, "# M        = %.4f\n", disk_nt_bh_mass);
-    fprintf(stream, "# a        = %.4f\n", disk_nt_bh_spin);
-    fprintf(stream, "# rmin     = %.4f\n", disk_nt_disk_rms);
+    fprintf(stream, "# M        = %.4f\n", d->M);
+    fprintf(stream, "# a        = %.4f\n", d->a);
+    fprintf(stream, "# rmin     = %.4f\n", d->rms);
     fprintf(stream, "# rmax     = %.4f\n", disk_rmax);
-    fprintf(stream, "# alpha    = %.4f\n", disk_nt_disk_alpha);
-    fprintf(stream, "# options  = %d\n",   disk_nt_options);
-    fprintf(stream, "# L        = %e\n", disk_nt_lumi());
-    fprintf(stream, "# mdot     = %e\n", disk_nt_mdot());
+    fprintf(stream, "# alpha    = %.4f\n", d->alpha);
+    fprintf(stream, "# options  = %d\n",   d->options);
+    fprintf(stream, "# L        = %e\n", disknt_lumi(d));
+    fprintf(stream, "# mdot     = %e\n", disknt_mdot(d));
     fprintf(stream, "#-------------------------------------------\n");
     fprintf(stream, "# r   flux   sigma   ell   vr   H   dH/dr\n");
     fprintf(stream, "#-------------------------------------------\n");
 
     double r;
-    for (r=disk_nt_disk_rms; r<disk_rmax; r*=1.05) {
+    for (r=d->rms; r<disk_rmax; r*=1.05) {
         fprintf(stream,
             "%e  %e  %e  %e  %e  %e  %e\n",
             r,
-            disk_nt_flux(r),
-            disk_nt_sigma(r),
-            disk_nt_ell(r),
-            disk_nt_vr(r),
-            disk_nt_h(r),
-            disk_nt_dhdr(r)
+            disknt_flux(d, r),
+            disknt_sigma(d, r),
+            disknt_ell(d, r),
+            disknt_vr(d, r),
+            disknt_h(d, r),
+            disknt_dhdr(d, r)
         );
     }
     
@@ -365,21 +493,186 @@ void disk_nt_dump(char* filename)
 }
 
 
+
+
+
+
+//-----------------------------------------------------------------
+// disk model with default context (not thread-safe)
+//-----------------------------------------------------------------
+
+
 //! \cond SKIP
-// private routine to iteratively find mdot that corresponds to given luminosity
+static sim5disknt disk_nt_default = {
+    .M = 10.0, .a = 0.0, .mdot = 0.1, .rms = 6.0, .alpha = 0.1, .options = 0,
+    .x0 = 2.449489742783178, .x1 = 1.7320508075688772, .x2 = 6.123233995736766e-17, .x3 = -1.7320508075688772
+};
+//! \endcond
+
+
+
 DEVICEFUNC
-double disk_nt_find_mdot_for_luminosity(double L0)
+int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int options)
+//! Sets up a relativistic (Novikov-Thorne) model of a thin disk.
+//! Same as disknt_setup(), but sets up the default disk context that is used 
+//! by all `disk_nt_*` routines.
+//!
+//! @param M mass of the central BH [M_sun]
+//! @param a spin of the central BH [0..1]
+//! @param mdot_or_L mass accretion rate (default) or luminosity (both in eddington units; see sim5const.h)
+//! @param alpha viscosity parameter
+//! @param options optional switches (see disknt_setup())
+//!
+//! @result A status code (currently returns always zero)
 {
-    double L;
+    return disknt_setup(&disk_nt_default, M, a, mdot_or_L, alpha, options);
+}
 
-    double fce(double xmdot) {
-        disk_nt_disk_mdot = xmdot;
-        return L0-disk_nt_lumi();
-    }
 
-    int res = rtbis(0.0, 100.0, 1e-6, fce, &L);
-    return (res) ? L : 0.0;
+
+DEVICEFUNC
+void disk_nt_done()
+//! Finalize the disk model.
+//! Cleans up and frees necessary memory.
+{
 }
-//! \endcond
+
+
+
+DEVICEFUNC
+double disk_nt_r_min()
+//! Minimal radius of the disk (disk inner edge).
+//! See disknt_r_min().
+//!
+//! @result Radius of disk inner edge [GM/c2]
+{
+    return disknt_r_min(&disk_nt_default);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_flux(double r)
+//! Local flux from one side of the disk.
+//! See disknt_flux().
+//!
+//! @param r radius of emission [GM/c2]
+//!
+//! @result Total outgoing flux from unit area on one side of the disk [erg cm-2 s-1]. 
+{
+    return disknt_flux(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_lumi()
+//! Total disk luminosity.
+//! See disknt_lumi().
+//!
+//! @result Total disk luminosity of both surfaces [L_Edd]
+{
+    return disknt_lumi(&disk_nt_default);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_mdot()
+//! Mass accretion rate.
+//! See disknt_mdot().
+//!
+//! @result Mass accretion rate in Eddington units.
+{
+    return disknt_mdot(&disk_nt_default);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_sigma(double r)
+//! Column density.
+//! See disknt_sigma().
+//!
+//! @param r radius (measured in equatorial plane) [rg]
+//!
+//! @result Midplane column density in [g/cm2].
+{
+    return disknt_sigma(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_ell(double r)
+//! Specific angular momentum.
+//! See disknt_ell().
+//!
+//! @param r radius (measured in equatorial plane) [rg]
+//!
+//! @result Specific angular momentum in [g.u.].
+{
+    return disknt_ell(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_vr(double r)
+//! Radial velocity.
+//! See disknt_vr().
+//!
+//! @param r radius (measured in equatorial plane) [rg]
+//!
+//! @result Radial velocity in [speed_of_light].
+{
+    return disknt_vr(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_h(double r)
+//! Surface height.
+//! See disknt_h().
+//!
+//! @param r radius (measured in equatorial plane) [rg]
+//!
+//! @result Scale-height [rg].
+{
+    return disknt_h(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+double disk_nt_dhdr(double r)
+//! Derivative of surface height.
+//! See disknt_dhdr().
+//!
+//! @param r radius (measured in equatorial plane) [rg]
+//!
+//! @result Derivative of surface height.
+{
+    return disknt_dhdr(&disk_nt_default, r);
+}
+
+
+
+DEVICEFUNC
+void disk_nt_dump(char* filename)
+//! Prints the disk structure as a function of radius.
+//! See disknt_dump().
+//!
+//! @param filename Path to a file that should be written. If NULL then it prints to STDOUT. 
+{
+    disknt_dump(&disk_nt_default, filename);
+}
+
+
+
+#undef DISK_NT_LUMI_TABLE_N
+#undef DISK_NT_LUMI_TABLE_AMAX
+
 
 #endif
@@ -20,6 +20,35 @@
 extern "C" {
 #endif
 
+//! Context of a Novikov-Thorne disk model.
+//! Holds all parameters of one disk model, so that multiple disks can be used independently
+//! (e.g. from different threads). The structure is filled by disknt_setup().
+typedef struct sim5disknt {
+    double M;           // mass of the central BH [M_sun]
+    double a;           // spin of the central BH
+    double mdot;        // mass accretion rate [Mdot_Edd]
+    double rms;         // radius of the disk inner edge [rg]
+    double alpha;       // viscosity parameter
+    int options;        // options passed to disknt_setup()
+    double x0;          // sqrt(rms)
+    double x1, x2, x3;  // roots of x^3-3x+2a=0 (PT74)
+} sim5disknt;
+
+
+DEVICEFUNC int disknt_setup(sim5disknt* d, double M, double a, double mdot_or_L, double alpha, int options);
+DEVICEFUNC double disknt_r_min(sim5disknt* d);
+DEVICEFUNC double disknt_flux(sim5disknt* d, double r);
+DEVICEFUNC double disknt_lumi(sim5disknt* d);
+DEVICEFUNC double disknt_lumi_integrate(sim5disknt* d);
+DEVICEFUNC double disknt_lumi_per_mdot(double a);
+DEVICEFUNC double disknt_mdot(sim5disknt* d);
+DEVICEFUNC double disknt_sigma(sim5disknt* d, double r);
+DEVICEFUNC double disknt_ell(sim5disknt* d, double r);
+DEVICEFUNC double disknt_vr(sim5disknt* d, double r);
+DEVICEFUNC double disknt_h(sim5disknt* d, double r);
+DEVICEFUNC double disknt_dhdr(sim5disknt* d, double r);
+DEVICEFUNC void disknt_dump(sim5disknt* d, char* filename);
+
 DEVICEFUNC int disk_nt_setup(double M, double a, double mdot_or_L, double alpha, int options);
 DEVICEFUNC void disk_nt_done();
 DEVICEFUNC double disk_nt_r_min();
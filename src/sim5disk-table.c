@@ -0,0 +1,245 @@
+//************************************************************************
+//    sim5disk-table.c
+//************************************************************************
+
+//! \file sim5disk-table.c
+//! Radial lookup tables for disks
+//! 
+//! Provides a precomputed radial table of kinematic quantities of an axisymmetric thin disk.
+//! For such a disk, the fluid four-velocity, its angular velocity and the tetrad attached to 
+//! the disk surface depend only on radius. The table evaluates the disk model (local flux, 
+//! angular velocity, radial drift and surface slope) once on a grid that is uniform in log(R)
+//! and later gives their values by interpolation, which avoids calling the model functions 
+//! for each photon or image pixel. The four-velocity and the tetrad are rebuilt from the 
+//! interpolated quantities and the exact metric, so that they stay normalized and orthogonal 
+//! also between the table nodes.
+//! The table is read-only after it has been built, so it can be shared by multiple threads.
+
+
+
+#ifndef CUDA
+
+
+//! \cond SKIP
+// layout of tabulated quantities for one radial node
+#define DISKTABLE_FLUX      0
+#define DISKTABLE_OMEGA     1
+#define DISKTABLE_VR        2
+#define DISKTABLE_DHDR      3
+#define DISKTABLE_NQ        4
+//! \endcond
+
+
+
+DEVICEFUNC
+int disktable_init(
+    sim5disktable* t, double a, double R_min, double R_max, int N,
+    double (*flux)(double R, void* ctx), double (*ell)(double R, void* ctx),
+    double (*vr)(double R, void* ctx), double (*dhdr)(double R, void* ctx), void* ctx)
+//! Builds a radial table for a disk.
+//! Evaluates the disk model at `N` radii between `R_min` and `R_max`, which are distributed 
+//! uniformly in log(R), and stores the local flux, angular velocity, radial velocity
+//! and surface slope of the disk in the equatorial plane.
+//!
+//! @param t pointer to the table structure
+//! @param a black hole spin
+//! @param R_min inner radius of the table (e.g. the disk inner edge) [rg]
+//! @param R_max outer radius of the table [rg]
+//! @param N number of radial nodes (N>=2)
+//! @param flux local flux as a function of radius
+//! @param ell specific angular momentum of the fluid as a function of radius
+//! @param vr radial velocity of the fluid as a function of radius (can be NULL for zero)
+//! @param dhdr surface slope dH/dR as a function of radius (can be NULL for zero)
+//! @param ctx context pointer that is passed to the functions (e.g. a disk model handle)
+//!
+//! @result Returns 0 on success or -1 on invalid input or memory allocation failure.
+{
+    int i;
+
+    t->data = NULL;
+    if ((N < 2) || (R_min <= 0.0) || (R_max <= R_min)) {
+        error("disktable_init: invalid table range (R_min=%e, R_max=%e, N=%d)", R_min, R_max, N);
+        return -1;
+    }
+
+    t->a = a;
+    t->R_min = R_min;
+    t->R_max = R_max;
+    t->N = N;
+    t->logR_min = log(R_min);
+    t->dlogR_1 = (double)(N-1)/(log(R_max)-log(R_min));
+    t->data = (double*)malloc(N*DISKTABLE_NQ*sizeof(double));
+    if (!t->data) {
+        error("disktable_init: cannot allocate memory");
+        return -1;
+    }
+
+    for (i=0; i<N; i++) {
+        double R = exp(t->logR_min + (double)(i)/t->dlogR_1);
+        double* node = t->data + i*DISKTABLE_NQ;
+        sim5metric m;
+
+        kerr_metric(a, R, 0.0, &m);
+        node[DISKTABLE_FLUX]  = flux(R, ctx);
+        node[DISKTABLE_OMEGA] = Omega_from_ell(ell(R, ctx), &m);
+        node[DISKTABLE_VR]    = vr ? vr(R, ctx) : 0.0;
+        node[DISKTABLE_DHDR]  = dhdr ? dhdr(R, ctx) : 0.0;
+    }
+
+    return 0;
+}
+
+
+
+DEVICEFUNC
+void disktable_done(sim5disktable* t)
+//! Frees the table.
+//!
+//! @param t pointer to the table structure
+{
+    free(t->data);
+    t->data = NULL;
+    t->N = 0;
+}
+
+
+
+//! \cond SKIP
+// gives the table node and the interpolation weight for radius R (R is clamped to the table range);
+// returns NULL for R that is not a positive number
+DEVICEFUNC INLINE
+static double* disktable_node(sim5disktable* t, double R, double* w)
+{
+    if (!(R > 0.0)) {
+        SIM5_ERROR(SIM5_ERR_RANGE, "disktable_node", "invalid radius (R=%e)", R);
+        return NULL;
+    }
+    double x = (log(R)-t->logR_min)*t->dlogR_1;
+    if (x < 0.0) x = 0.0;
+    if (x > (double)(t->N-1)) x = (double)(t->N-1);
+    int i = (int)x;
+    if (i > t->N-2) i = t->N-2;
+    *w = x - (double)(i);
+    return t->data + i*DISKTABLE_NQ;
+}
+//! \endcond
+
+
+
+DEVICEFUNC
+double disktable_flux(sim5disktable* t, double R)
+//! Local flux from the table.
+//! Gives linearly interpolated value of the tabulated flux. Outside of the table range
+//! (and for invalid R) the flux is zero.
+//!
+//! @param t pointer to the table structure
+//! @param R radius [rg]
+//!
+//! @result Local flux in units of the tabulated flux function.
+{
+    if (!((R >= t->R_min) && (R <= t->R_max))) return 0.0;
+    double w;
+    double* node = disktable_node(t, R, &w);
+    return (1.-w)*node[DISKTABLE_FLUX] + w*node[DISKTABLE_NQ+DISKTABLE_FLUX];
+}
+
+
+
+DEVICEFUNC
+double disktable_Omega(sim5disktable* t, double R)
+//! Angular velocity of the fluid from the table.
+//! Radii outside the table range are clamped to its boundary.
+//!
+//! @param t pointer to the table structure
+//! @param R radius [rg]
+//!
+//! @result Angular velocity [g.u.] (NAN if R is not a positive number).
+{
+    double w;
+    double* node = disktable_node(t, R, &w);
+    if (!node) return NAN;
+    return (1.-w)*node[DISKTABLE_OMEGA] + w*node[DISKTABLE_NQ+DISKTABLE_OMEGA];
+}
+
+
+
+DEVICEFUNC
+void disktable_tetrad(sim5disktable* t, double R, sim5tetrad* tetrad)
+//! Surface tetrad from the table.
+//! Gives the tetrad of an observer comoving with the disk surface [see tetrad_surface()] 
+//! including the metric at the equatorial plane. The angular velocity, radial velocity and 
+//! surface slope are interpolated from the table and the tetrad is constructed for the exact
+//! metric at R, so it is orthonormal at any radius. The result can be passed directly 
+//! to bl2on() and on2bl(). Radii outside the table range are clamped to its boundary.
+//! If R is not a positive number, the tetrad is filled with NAN values.
+//!
+//! @param t pointer to the table structure
+//! @param R radius [rg]
+//! @param tetrad the tetrad (output)
+{
+    int j, k;
+    double w;
+    double* node1 = disktable_node(t, R, &w);
+    if (!node1) {
+        for (j=0; j<4; j++) for (k=0; k<4; k++) tetrad->e[j][k] = NAN;
+        kerr_metric(t->a, NAN, 0.0, &tetrad->metric);
+        return;
+    }
+    double* node2 = node1 + DISKTABLE_NQ;
+    double Omega = (1.-w)*node1[DISKTABLE_OMEGA] + w*node2[DISKTABLE_OMEGA];
+    double vr    = (1.-w)*node1[DISKTABLE_VR]    + w*node2[DISKTABLE_VR];
+    double dhdr  = (1.-w)*node1[DISKTABLE_DHDR]  + w*node2[DISKTABLE_DHDR];
+    sim5metric m;
+    kerr_metric(t->a, fmin(fmax(R, t->R_min), t->R_max), 0.0, &m);
+    tetrad_surface(&m, Omega, vr, dhdr, tetrad);
+}
+
+
+
+DEVICEFUNC
+void disktable_fourvelocity(sim5disktable* t, double R, double U[4])
+//! Four-velocity of the fluid from the table.
+//! Gives contravariant four-velocity of the fluid, which is the time-like vector 
+//! of the surface tetrad [see disktable_tetrad()]. Radii outside the table range are 
+//! clamped to its boundary.
+//!
+//! @param t pointer to the table structure
+//! @param R radius [rg]
+//! @param U four-velocity (output)
+{
+    int j;
+    sim5tetrad tetrad;
+    disktable_tetrad(t, R, &tetrad);
+    for (j=0; j<4; j++) U[j] = tetrad.e[0][j];
+}
+
+
+
+DEVICEFUNC
+double disktable_gfactor(sim5disktable* t, double R, double k[4])
+//! Redshift factor.
+//! Gives the ratio of photon energy measured at infinity to the energy measured by the fluid
+//! at radius R, \f$g = k_t / (k_\mu U^\mu)\f$, for a photon with momentum `k` at the disk.
+//!
+//! @param t pointer to the table structure
+//! @param R radius [rg]
+//! @param k photon momentum at the disk (contravariant components)
+//!
+//! @result Redshift factor g.
+{
+    sim5tetrad tetrad;
+    disktable_tetrad(t, R, &tetrad);
+    sim5metric* m = &tetrad.metric;
+    double k_t = m->g00*k[0] + m->g03*k[3];
+    return k_t/dotprod(k, tetrad.e[0], m);
+}
+
+
+#undef DISKTABLE_FLUX
+#undef DISKTABLE_OMEGA
+#undef DISKTABLE_VR
+#undef DISKTABLE_DHDR
+#undef DISKTABLE_NQ
+
+#endif //CUDA
+
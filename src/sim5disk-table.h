@@ -0,0 +1,44 @@
+//************************************************************************
+//    sim5disk-table.h - radial lookup tables for axisymmetric disks
+//************************************************************************
+
+
+#ifndef _SIM5DISKTABLE_H
+#define _SIM5DISKTABLE_H
+
+#ifndef CUDA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim5disktable {
+    double a;               // black hole spin
+    double R_min;           // inner radius of the table [rg]
+    double R_max;           // outer radius of the table [rg]
+    int N;                  // number of radial nodes
+    double logR_min;        // log(R_min)
+    double dlogR_1;         // inverse step of the grid in log(R)
+    double* data;           // tabulated quantities (DISKTABLE_NQ values per node)
+} sim5disktable;
+
+
+DEVICEFUNC int disktable_init(
+    sim5disktable* t, double a, double R_min, double R_max, int N,
+    double (*flux)(double R, void* ctx), double (*ell)(double R, void* ctx),
+    double (*vr)(double R, void* ctx), double (*dhdr)(double R, void* ctx), void* ctx);
+DEVICEFUNC void disktable_done(sim5disktable* t);
+DEVICEFUNC double disktable_flux(sim5disktable* t, double R);
+DEVICEFUNC double disktable_Omega(sim5disktable* t, double R);
+DEVICEFUNC void disktable_fourvelocity(sim5disktable* t, double R, double U[4]);
+DEVICEFUNC void disktable_tetrad(sim5disktable* t, double R, sim5tetrad* tetrad);
+DEVICEFUNC double disktable_gfactor(sim5disktable* t, double R, double k[4]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CUDA
+
+#endif
+
@@ -18,295 +18,544 @@
 //! of them. Calls to those methods in SIM5 are passed to the linked library and the result is returned 
 //! by a wrapper function. See a demo of how to use this functionality in the examples folder.
 //! 
-//! NOTE: This unit uses static variables to store persistent information about the linked library. 
-//! As a result, routines in this module are NOT thread-safe in a sense different threads cannot each 
-//! link a different library. They can, however, all make calls to the already linked library.
-//! For the same reasons, the routines declared here are not available to CUDA.
+//! Each linked library is represented by a handle (sim5diskmodel) that is returned by sim5_diskmodel_open()
+//! and that is passed to all `sim5_diskmodel_*` routines, so several different models can be used at once.
+//! The older `diskmodel_*` interface operates on a single default handle.
+//!
+//! Since version 2 of the interface (DISKMODEL_ABI_VERSION), a library may also declare 
+//! `int diskmodel_abi_version()` and `void diskmodel_eval_batch(const double* R, int n, int quantity, double* out)`
+//! that evaluates a quantity for an array of radii in one call. If present, sim5_diskmodel_eval_batch() 
+//! uses it, otherwise it falls back to calling the scalar functions for each radius.
+//!
+//! Open models are kept in a registry, where they can be looked up by their identifier (sim5_diskmodel_get()).
+//! Each model keeps its own library state: if the same library is opened more than once, each further copy 
+//! is loaded into a separate link-map namespace (dlmopen), so that static variables of the library 
+//! (e.g. the model parameters set by its diskmodel_init) are not shared between the models.
+//! The number of namespaces is limited by the C library: glibc has 16 of them (including the main one)
+//! and each loads its own copy of libc, which may exhaust the static TLS space even earlier (typically after
+//! about 10 copies). Only a few copies of one library can thus be open at once; when no namespace
+//! is left, sim5_diskmodel_open() fails and returns NULL. Different libraries do not need a new namespace.
+//! Opening and closing of models is thread-safe. Evaluation of an open model does not modify any state
+//! in this module, so it can be done concurrently from many threads, provided the library's functions 
+//! themselves are reentrant (which is the case for models that only read their state after initialization).
+//! Repeated evaluations can be further sped up by tabulating the radial profiles of the model (sim5_diskmodel_cache()).
+//!
+//! The module is not part of the amalgamated sim5lib.c, as it requires linking with `-ldl`;
+//! `make lib` compiles it separately to src/sim5disk.o.
+//! The routines declared here are not available to CUDA.
 
 
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <dlfcn.h>
+#include "sim5lib.h"
+#include "sim5disk.h"
 
 
 
-static void*  lib_handle = NULL;
-static int    (*_diskmodel_init)(double M, double a, char* params) = NULL;
-static void   (*_diskmodel_done)() = NULL;
-static char*  (*_diskmodel_name)() = NULL;
-//static void   (*_diskmodel_help)() = NULL;
-static double (*_diskmodel_r_min)() = NULL;
-static double (*_diskmodel_flux)(double R) = NULL;
-static double (*_diskmodel_lumi)() = NULL;
-static double (*_diskmodel_mdot)() = NULL;
-static double (*_diskmodel_sigma)(double R) = NULL;
-static double (*_diskmodel_ell)(double R) = NULL;
-static double (*_diskmodel_vr)(double R) = NULL;
-static double (*_diskmodel_h)(double R) = NULL;
-static double (*_diskmodel_dhdr)(double R) = NULL;
-static double (*_diskmodel_eval)(double R, int quantity) = NULL;
-static void   (*_diskmodel_params)(FILE* output) = NULL;
+//! \cond SKIP
+// default model for the diskmodel_* interface
+static sim5diskmodel* diskmodel_default = NULL;
 
+// registry of open models
+static sim5diskmodel* diskmodel_registry[DISKMODEL_MAX_MODELS];
+static char diskmodel_registry_lock = 0;
 
+// number of tabulated quantities in the cache
+#define DISKMODEL_CACHE_NQ 6
 
 
-int diskmodel_init(char *modellib, double M, double a, char* params)
-//! External disk model initialization.
-//! Loads the compiled library, links is into the program and calls its initialization routine. 
-//! All the required functions have to be declared in the library.
-//!
-//! @param modellib  filesystem path to the library (string)
-//! @param M       mass of BH [Msun]
-//! @param a       spin of BH [0..1]
-//! @param params  parametres that are passed to the library initialization function
-//! 
-//! @result Return the result of the library's initialization function or -1 of the library could not 
-//! loaded or be initialized.
+static void diskmodel_registry_acquire()
 {
-    if (lib_handle) {
-        fprintf(stderr, "diskmodel_init: cannot open '%s', close current model first\n", modellib);
-        return -1;
+    while (__atomic_test_and_set(&diskmodel_registry_lock, __ATOMIC_ACQUIRE));
+}
+
+
+static void diskmodel_registry_release()
+{
+    __atomic_clear(&diskmodel_registry_lock, __ATOMIC_RELEASE);
+}
+
+
+// binds a function from the library; prints an error message if the function is required, but missing
+static int diskmodel_bind(sim5diskmodel* model, void** func_var, char* func_name, int required)
+{
+    char *errstr;
+    dlerror();
+    (*func_var) = dlsym(model->lib_handle, func_name);
+    errstr = dlerror();
+    if (!required) return *func_var != NULL;
+    if (errstr) fprintf(stderr, "diskmodel_init: error in function binding (%s; %s)\n", func_name, errstr);
+    if (!*func_var) fprintf(stderr, "diskmodel_init: missing function (%s)\n", func_name);
+    return *func_var != NULL;
+}
+
+
+// unlinks the library and frees the model structure (does not call model's done function)
+static void diskmodel_unload(sim5diskmodel* model)
+{
+    diskmodel_registry_acquire();
+    if ((model->id >= 0) && (diskmodel_registry[model->id] == model)) diskmodel_registry[model->id] = NULL;
+    diskmodel_registry_release();
+
+    if (model->lib_handle) dlclose(model->lib_handle);
+    free(model->cache);
+    free(model->lib_path);
+    free(model);
+}
+
+
+// loads the library, binds its functions and registers the model
+static sim5diskmodel* diskmodel_load(char *modellib, double M, double a)
+{
+    int i, shared = 0;
+
+    sim5diskmodel* model = (sim5diskmodel*)calloc(1, sizeof(sim5diskmodel));
+    if (!model) {
+        fprintf(stderr, "diskmodel_init: cannot allocate memory\n");
+        return NULL;
     }
 
-    lib_handle = dlopen(modellib, RTLD_NOW);
-    if (!lib_handle) {
-        fprintf(stderr, "diskmodel_init: opening failed (%s)\n", dlerror());
-        return -1;
+    model->id = -1;
+    model->M  = M;
+    model->a  = a;
+    model->lib_path = strdup(modellib);
+
+    // claim a slot in the registry and check if the library is in use by other model
+    diskmodel_registry_acquire();
+    for (i=0; i<DISKMODEL_MAX_MODELS; i++) {
+        if (!diskmodel_registry[i]) {
+            if (model->id < 0) model->id = i;
+            continue;
+        }
+        if (strcmp(diskmodel_registry[i]->lib_path, modellib) == 0) shared = 1;
+    }
+    if (model->id >= 0) diskmodel_registry[model->id] = model;
+    diskmodel_registry_release();
+
+    if (model->id < 0) {
+        fprintf(stderr, "diskmodel_init: cannot open '%s', too many open models\n", modellib);
+        diskmodel_unload(model);
+        return NULL;
     }
-    
-    int bind_func(void** func_var, char* func_name) {
-        char *errstr;
-        (*func_var) = dlsym(lib_handle, func_name);
-        errstr = dlerror();
-        if (errstr) fprintf(stderr, "diskmodel_init: error in function binding (%s; %s)\n", func_name, errstr);
-        if (!*func_var) fprintf(stderr, "diskmodel_init: missing function (%s)\n", func_name);
-        return *func_var != NULL;
+
+    // a library that is already in use is loaded to a new namespace to get its own copy of static data
+    model->lib_handle = shared ? dlmopen(LM_ID_NEWLM, modellib, RTLD_NOW|RTLD_LOCAL) : dlopen(modellib, RTLD_NOW|RTLD_LOCAL);
+    if (!model->lib_handle) {
+        fprintf(stderr, "diskmodel_init: opening failed (%s)\n", dlerror());
+        diskmodel_unload(model);
+        return NULL;
     }
 
-    if (!bind_func((void**)&_diskmodel_init,  "diskmodel_init")) goto error;
-    if (!bind_func((void**)&_diskmodel_done,  "diskmodel_done")) goto error;
-    if (!bind_func((void**)&_diskmodel_name,  "diskmodel_name")) goto error;
-    //if (!bind_func((void**)&_diskmodel_help,  "diskmodel_help")) goto error;
-    if (!bind_func((void**)&_diskmodel_params,"diskmodel_params")) goto error;
-    if (!bind_func((void**)&_diskmodel_r_min, "diskmodel_r_min")) goto error;
-    if (!bind_func((void**)&_diskmodel_mdot,  "diskmodel_mdot")) goto error;
-    if (!bind_func((void**)&_diskmodel_lumi,  "diskmodel_lumi")) goto error;
-    if (!bind_func((void**)&_diskmodel_flux,  "diskmodel_flux")) goto error;
-    if (!bind_func((void**)&_diskmodel_sigma, "diskmodel_sigma")) goto error;
-    if (!bind_func((void**)&_diskmodel_ell,     "diskmodel_ell")) goto error;
-    if (!bind_func((void**)&_diskmodel_vr,    "diskmodel_vr")) goto error;
-    if (!bind_func((void**)&_diskmodel_h,     "diskmodel_h")) goto error;
-    if (!bind_func((void**)&_diskmodel_dhdr,  "diskmodel_dhdr")) goto error;
-    if (!bind_func((void**)&_diskmodel_eval,  "diskmodel_eval")) goto error;
-
-    return _diskmodel_init(M, a, params);
+    if (!diskmodel_bind(model, (void**)&model->init,   "diskmodel_init", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->done,   "diskmodel_done", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->name,   "diskmodel_name", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->params, "diskmodel_params", 1)) goto error;
+    if (!diskmodel_bind(model, (void**)&model->r_min,  "diskmodel_r_min", 1))  goto error;
+    if (!diskmodel_bind(model, (void**)&model->mdot,   "diskmodel_mdot", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->lumi,   "diskmodel_lumi", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->flux,   "diskmodel_flux", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->sigma,  "diskmodel_sigma", 1))  goto error;
+    if (!diskmodel_bind(model, (void**)&model->ell,    "diskmodel_ell", 1))    goto error;
+    if (!diskmodel_bind(model, (void**)&model->vr,     "diskmodel_vr", 1))     goto error;
+    if (!diskmodel_bind(model, (void**)&model->h,      "diskmodel_h", 1))      goto error;
+    if (!diskmodel_bind(model, (void**)&model->dhdr,   "diskmodel_dhdr", 1))   goto error;
+    if (!diskmodel_bind(model, (void**)&model->eval,   "diskmodel_eval", 1))   goto error;
+
+    // optional batch interface (ABI version 2)
+    int (*abi_version)() = NULL;
+    model->abi_version = 1;
+    if (diskmodel_bind(model, (void**)&abi_version, "diskmodel_abi_version", 0)) model->abi_version = abi_version();
+    if (model->abi_version >= DISKMODEL_ABI_BATCH) diskmodel_bind(model, (void**)&model->eval_batch, "diskmodel_eval_batch", 0);
+
+    return model;
 
     // error handling part    
     error:
-    dlclose(lib_handle);
-    lib_handle = NULL;
-    return -1;
+    diskmodel_unload(model);
+    return NULL;
 }
 
 
+// gives cached value of a standard quantity (index 0..DISKMODEL_CACHE_NQ-1)
+static inline double diskmodel_cache_eval(sim5diskmodel* model, int q, double R)
+{
+    double x = (log(R)-model->cache_logR_min)*model->cache_dlogR_1;
+    int i = (int)x;
+    if (i > model->cache_N-2) i = model->cache_N-2;
+    double w = x - (double)(i);
+    double* node = model->cache + i*DISKMODEL_CACHE_NQ + q;
+    return (1.-w)*node[0] + w*node[DISKMODEL_CACHE_NQ];
+}
 
+// tells if R is covered by the cache
+#define DISKMODEL_CACHED(model,R) ((model->cache_N > 0) && (R >= model->cache_R_min) && (R <= model->cache_R_max))
+//! \endcond
 
-void diskmodel_done()
+
+
+
+//-----------------------------------------------------------------
+// model with handle
+//-----------------------------------------------------------------
+
+
+sim5diskmodel* sim5_diskmodel_open(char *modellib, double M, double a, char* params)
+//! External disk model initialization.
+//! Loads the compiled library, links it into the program and calls its initialization routine. 
+//! All the required functions have to be declared in the library. The returned handle 
+//! is used in all other `sim5_diskmodel_*` calls and it has to be freed by sim5_diskmodel_close().
+//!
+//! @param modellib  filesystem path to the library (string)
+//! @param M       mass of BH [Msun]
+//! @param a       spin of BH [0..1]
+//! @param params  parametres that are passed to the library initialization function
+//! 
+//! @result Handle of the model or NULL if the library could not be loaded or its initialization failed 
+//! (returned non-zero value). Opening a library that is already open by another model needs a new link-map 
+//! namespace, which fails when the namespaces of the C library have run out (see the notes at the top of this file).
+{
+    sim5diskmodel* model = diskmodel_load(modellib, M, a);
+    if (!model) return NULL;
+
+    int status = model->init(M, a, params);
+    if (status != 0) {
+        fprintf(stderr, "diskmodel_init: model initialization failed (%s; status=%d)\n", modellib, status);
+        diskmodel_unload(model);
+        return NULL;
+    }
+
+    return model;
+}
+
+
+
+void sim5_diskmodel_close(sim5diskmodel* model)
 //! External disk model finitialization.
 //! Frees memory and unlinks the libraray.
+//!
+//! @param model model handle
 {
-    _diskmodel_done();
+    if (!model) return;
+    model->done();
+    diskmodel_unload(model);
+}
 
-    dlclose(lib_handle);
-    lib_handle = NULL;
+
+
+sim5diskmodel* sim5_diskmodel_get(int id)
+//! Model lookup.
+//! Gives the handle of an open model by its identifier (`model->id`).
+//!
+//! @param id model identifier (0..DISKMODEL_MAX_MODELS-1)
+//!
+//! @result Handle of the model or NULL if there is no open model with this identifier.
+{
+    if ((id < 0) || (id >= DISKMODEL_MAX_MODELS)) return NULL;
+    return __atomic_load_n(&diskmodel_registry[id], __ATOMIC_ACQUIRE);
 }
 
 
 
+int sim5_diskmodel_cache(sim5diskmodel* model, double R_max, int N)
+//! Tabulation of radial profiles.
+//! Evaluates the standard quantities (flux, sigma, ell, vr, h, dhdr) of the model on a grid 
+//! of `N` radii between the disk inner edge and `R_max` (uniform in log(R)) and keeps them with the model. 
+//! After that, sim5_diskmodel_flux(), sim5_diskmodel_sigma(), etc. and sim5_diskmodel_eval_batch() return 
+//! values linearly interpolated from the table for radii within the table range and do not call the library.
+//! The table is built using the batch interface of the library, if available.
+//! The cache shall be set up before the model is used from multiple threads. 
+//! Calling the function with N=0 switches the cache off.
+//!
+//! @param model model handle
+//! @param R_max outer radius of the table [rg]
+//! @param N number of radial nodes (N>=2 or 0 to switch the cache off)
+//!
+//! @result Returns 0 on success or -1 on invalid input or memory allocation failure.
+{
+    int i, q;
+    const int quantities[DISKMODEL_CACHE_NQ] = {
+        DISKMODEL_FLUX, DISKMODEL_SIGMA, DISKMODEL_ELL, DISKMODEL_VR, DISKMODEL_H, DISKMODEL_DHDR
+    };
+
+    free(model->cache);
+    model->cache = NULL;
+    model->cache_N = 0;
+    if (N == 0) return 0;
+
+    double R_min = model->r_min();
+    if ((N < 2) || (R_max <= R_min)) {
+        fprintf(stderr, "diskmodel_cache: invalid table range (R_min=%e, R_max=%e, N=%d)\n", R_min, R_max, N);
+        return -1;
+    }
 
-char* diskmodel_name()
+    double* R = (double*)malloc(N*sizeof(double));
+    double* Q = (double*)malloc(N*sizeof(double));
+    double* cache = (double*)malloc(N*DISKMODEL_CACHE_NQ*sizeof(double));
+    if ((!R) || (!Q) || (!cache)) {
+        fprintf(stderr, "diskmodel_cache: cannot allocate memory\n");
+        free(R); free(Q); free(cache);
+        return -1;
+    }
+
+    double logR_min = log(R_min);
+    double dlogR = (log(R_max)-logR_min)/(double)(N-1);
+    for (i=0; i<N; i++) R[i] = exp(logR_min + dlogR*(double)(i));
+    R[0] = R_min;
+    R[N-1] = R_max;
+
+    for (q=0; q<DISKMODEL_CACHE_NQ; q++) {
+        sim5_diskmodel_eval_batch(model, R, N, quantities[q], Q);
+        for (i=0; i<N; i++) cache[i*DISKMODEL_CACHE_NQ+q] = Q[i];
+    }
+    free(R);
+    free(Q);
+
+    model->cache_R_min    = R_min;
+    model->cache_R_max    = R_max;
+    model->cache_logR_min = logR_min;
+    model->cache_dlogR_1  = 1./dlogR;
+    model->cache          = cache;
+    model->cache_N        = N;
+    return 0;
+}
+
+
+
+char* sim5_diskmodel_name(sim5diskmodel* model)
 //! Model name.
 //! Returns a pointer to a string with the model's name.
+//!
+//! @param model model handle
 {
-    return _diskmodel_name();
+    return model->name();
 }
 
 
 
-double diskmodel_r_min()
+double sim5_diskmodel_r_min(sim5diskmodel* model)
 //! Minimal radius of the disk (disk inner edge).
 //! Gives minimal value for radius for which the functions provide valid results. 
 //! E.g. for NT disk, this corresponds to the radius of the marginally stable orbit.
 //!
+//! @param model model handle
+//!
 //! @result Radius of disk inner edge [GM/c2]
 {
-    return _diskmodel_r_min();
+    return model->r_min();
 }
 
 
 
-double diskmodel_mdot()
+double sim5_diskmodel_mdot(sim5diskmodel* model)
 //! Mass accretion rate.
 //! Returns mass accretion rate in Eddington units of (Mdot_Edd*M).
 //!
+//! @param model model handle
+//!
 //! @result Mass accretion rate in Eddington units.
 {
-    return _diskmodel_mdot();
+    return model->mdot();
 }
 
 
 
-double diskmodel_lumi()
+double sim5_diskmodel_lumi(sim5diskmodel* model)
 //! Total disk luminosity.
-//! Luminosity is obtained by integrating local flux over the surface area of the disk (both sides)
-//! going into the whole sky (4pi solid angle). 
-//! The integration makes a proper transformation of the flux from local to coordinate frame, but 
-//! it ignores other relativistic effects, e.g. light bending.
-//!
-//! \f[L = 2 * 2\pi \int F(r) (-U_t) r dr\f]
-//!
-//! @result Total disk luminosity of both surfaces [erg s-1]
-{
-    const float disk_rmax = 1e5;
-
-    // integrate disk luminosity from r_ms to disk_rmax rg
-    // - the integration uses 'logarithmic rule': L = \int f(x) dx \int f(x)*x d(log(x))
-
-    double func_luminosity(double log_r)
-    {
-        double r = exp(log_r);
-        // calculate U_t
-        double gtt = -1. + 2./r;
-        double gtf = -2.*disk_nt_bh_spin/r;
-        double gff = sqr(r) + sqr(disk_nt_bh_spin) + 2.*sqr(disk_nt_bh_spin)/r;
-        double Omega = 1./(disk_nt_bh_spin + pow(r,1.5));
-        double U_t = sqrt(-1.0/(gtt + 2.*Omega*gtf + sqr(Omega)*gff)) * (gtt + Omega*gtf);
-        double F = _diskmodel_flux(r);
-        // dL = 2pi*r*F(r) dr, extra r comes from log integration
-        return 2.*M_PI*r*2.0*(-U_t)*F * r;
-    }
-
-    double L = integrate_simpson(func_luminosity, log(disk_nt_disk_rms), log(disk_rmax), 1e-5);
-
-    // fix units to erg/s
-    L *= sqr(disk_nt_bh_mass*grav_radius);
-
-    return L/(L_Edd*disk_nt_bh_mass);
+//! Returns the luminosity of the disk as given by the model.
+//!
+//! @param model model handle
+//!
+//! @result Total disk luminosity of both surfaces [L_Edd]
+{
+    return model->lumi();
 }
 
 
 
-double diskmodel_flux(double R)
+double sim5_diskmodel_flux(sim5diskmodel* model, double R)
 //! Local flux from one side of the disk.
 //! Provides radial radiation flux dependence measured in local frame, i.e. flux measured by an 
 //! observer that is at rest with respect to the fluid.
 //!
+//! @param model model handle
 //! @param R radius of emission [GM/c2]
 //!
 //! @result Total outgoing flux from unit area on one side of the disk [erg cm-2 s-1]. 
 {
-    return _diskmodel_flux(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 0, R);
+    return model->flux(R);
 }
 
 
-double diskmodel_sigma(double R)
+
+double sim5_diskmodel_sigma(sim5diskmodel* model, double R)
 //! Column density.
 //! Returns midplane column density of the fluid, i.e. the fluid density integrated from midplane to the disk surface, 
 //! at a given radius.
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //!
 //! @result Midplane column density in [g/cm2].
 {
-    return _diskmodel_sigma(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 1, R);
+    return model->sigma(R);
 }
 
 
-double diskmodel_ell(double R)
+
+double sim5_diskmodel_ell(sim5diskmodel* model, double R)
 //! Specific angular momentum.
 //! Returns specific angular momentum of the fluid at given radius. 
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //!
 //! @result Specific angular momentum in [g.u.].
 {
-    return _diskmodel_ell(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 2, R);
+    return model->ell(R);
 }
 
 
 
-double diskmodel_vr(double R)
+double sim5_diskmodel_vr(sim5diskmodel* model, double R)
 //! Radial velocity.
-//! Returns bulk radial velocity of the fluid at given radius as measured by aan observer in the co-rotating frame.
+//! Returns bulk radial velocity of the fluid at given radius as measured by an observer in the co-rotating frame.
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //!
 //! @result Radial velocity in [speed_of_light].
 {
-    return _diskmodel_vr(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 3, R);
+    return model->vr(R);
 }
 
 
 
-double diskmodel_h(double R)
+double sim5_diskmodel_h(sim5diskmodel* model, double R)
 //! Surface height.
 //! Returns the scale-height of the surface of the disk above midplane at given radius. 
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //!
 //! @result Scale-height [rg].
 {
-    return _diskmodel_h(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 4, R);
+    return model->h(R);
 }
 
 
 
-double diskmodel_dhdr(double R)
+double sim5_diskmodel_dhdr(sim5diskmodel* model, double R)
 //! Derivative of surface height.
 //! Returns surface profile as derivative \f$dH/dR\f$ of its height above midplane at given radius. 
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //!
 //! @result Derivative of surface height.
 {
-    return _diskmodel_dhdr(R);
+    if (DISKMODEL_CACHED(model,R)) return diskmodel_cache_eval(model, 5, R);
+    return model->dhdr(R);
 }
 
 
-double diskmodel_eval(double R, int quantity)
+
+double sim5_diskmodel_eval(sim5diskmodel* model, double R, int quantity)
 //! Other quantity evaluation.
 //! Returns the value of a given quantity. The disk model may provide more quantities than the standard set. 
 //! Additional quantities may be accessed using this function by providing the quantity identifier.
 //!
+//! @param model model handle
 //! @param R radius (measured in equatorial plane) [rg]
 //! @param quantity quantity identified code
 //!
 //! @result The value of the requested quantity.
 {
-    return _diskmodel_eval(R, quantity);
+    return model->eval(R, quantity);
 }
 
 
 
-void diskmodel_params(FILE* stream)
+void sim5_diskmodel_eval_batch(sim5diskmodel* model, const double* R, int n, int quantity, double* out)
+//! Evaluation of a quantity for an array of radii.
+//! Evaluates a quantity for `n` radii in one call. If the library provides the batch interface 
+//! (diskmodel_eval_batch), the whole array is passed to the library, otherwise the respective 
+//! scalar function is called for each radius. Standard quantities are taken from the cache 
+//! of radial profiles, if it has been set up (see sim5_diskmodel_cache()).
+//!
+//! @param model model handle
+//! @param R array of radii (measured in equatorial plane) [rg]
+//! @param n number of radii
+//! @param quantity quantity code; either one of the standard quantities (DISKMODEL_FLUX, DISKMODEL_SIGMA, 
+//!        DISKMODEL_ELL, DISKMODEL_VR, DISKMODEL_H, DISKMODEL_DHDR) or a model-specific code (see sim5_diskmodel_eval())
+//! @param out array of values (output, must have space for `n` values)
+{
+    int i;
+
+    if ((model->cache_N > 0) && (quantity <= DISKMODEL_FLUX) && (quantity >= DISKMODEL_DHDR)) {
+        for (i=0; i<n; i++) {
+            switch (quantity) {
+                case DISKMODEL_FLUX:  out[i] = sim5_diskmodel_flux(model, R[i]);  break;
+                case DISKMODEL_SIGMA: out[i] = sim5_diskmodel_sigma(model, R[i]); break;
+                case DISKMODEL_ELL:   out[i] = sim5_diskmodel_ell(model, R[i]);   break;
+                case DISKMODEL_VR:    out[i] = sim5_diskmodel_vr(model, R[i]);    break;
+                case DISKMODEL_H:     out[i] = sim5_diskmodel_h(model, R[i]);     break;
+                case DISKMODEL_DHDR:  out[i] = sim5_diskmodel_dhdr(model, R[i]);  break;
+            }
+        }
+        return;
+    }
+
+    if (model->eval_batch) {
+        model->eval_batch(R, n, quantity, out);
+        return;
+    }
+
+    double (*func)(double R) = NULL;
+    switch (quantity) {
+        case DISKMODEL_FLUX:  func = model->flux;  break;
+        case DISKMODEL_SIGMA: func = model->sigma; break;
+        case DISKMODEL_ELL:   func = model->ell;   break;
+        case DISKMODEL_VR:    func = model->vr;    break;
+        case DISKMODEL_H:     func = model->h;     break;
+        case DISKMODEL_DHDR:  func = model->dhdr;  break;
+    }
+
+    if (func)
+        for (i=0; i<n; i++) out[i] = func(R[i]);
+    else
+        for (i=0; i<n; i++) out[i] = model->eval(R[i], quantity);
+}
+
+
+
+void sim5_diskmodel_params(sim5diskmodel* model, FILE* stream)
 //! Prints model parameters.
 //! Writes down the parameters of the model to the given stream.
- /!
+//!
+//! @param model model handle
 //! @param stream stream to write to
-
-    if (stream) _diskmodel_params(stream);
+{
+    if (stream) model->params(stream);
 }
 
 
 
-void diskmodel_dump(char* filename)
+void sim5_diskmodel_dump(sim5diskmodel* model, char* filename)
 //! Prints the disk structure as a function of radius.
 //! The function prints the profile of all quantities as a function of radius 
-//! from r_ms to some outer radius (~2000 rg). It prints to a file identified by its path (overwrites existing) and 
+//! from r_ms to some outer radius (~5000 rg). It prints to a file identified by its path (overwrites existing) and 
 //! if that is empty it prints to STDOUT.
 //!
+//! @param model model handle
 //! @param filename Path to a file that should be written. If NULL then it prints to STDOUT. 
 {
     FILE* output = stdout;
@@ -319,7 +568,7 @@ void diskmodel_dump(char* filename)
     fprintf(output, "# Disk model dump\n"); 
     fprintf(output, "#-------------------------------------------\n"); 
     fprintf(output, "# parameters:\n"); 
-    diskmodel_params(output);
+    sim5_diskmodel_params(model, output);
     fprintf(output, "#-------------------------------------------\n"); 
     fprintf(output, "# col1: radius [GM/c2]\n");
     fprintf(output, "# col2: flux (one side) [erg s-1 cm-2]\n");
@@ -330,16 +579,16 @@ void diskmodel_dump(char* filename)
     fprintf(output, "# col7: disk slope (derivative dH/dR of height with respect to equatorial radius) [none]\n");
     fprintf(output, "#-------------------------------------------\n"); 
     double r;
-    double r_min = diskmodel_r_min();
+    double r_min = sim5_diskmodel_r_min(model);
     for (r=r_min; r<5000.; r*=1.05) {
-        printf("%e  %e  %e  %e  %+e  %+e  %+e\n",
+        fprintf(output, "%e  %e  %e  %e  %+e  %+e  %+e\n",
             r, 
-            diskmodel_flux(r),
-            diskmodel_sigma(r),
-            diskmodel_ell(r),
-            diskmodel_vr(r),
-            diskmodel_h(r),
-            diskmodel_dhdr(r)
+            sim5_diskmodel_flux(model, r),
+            sim5_diskmodel_sigma(model, r),
+            sim5_diskmodel_ell(model, r),
+            sim5_diskmodel_vr(model, r),
+            sim5_diskmodel_h(model, r),
+            sim5_diskmodel_dhdr(model, r)
         );
     }
     fflush(output);
@@ -347,15 +596,206 @@ void diskmodel_dump(char* filename)
 }
 
 
-/*
-int main() {
-    
-    diskmodel_init("ntdisk/diskmodel-nt.so", 10.0, 0.0, NULL);
-    if (!lib_handle) return -1;
-    diskmodel_dump(NULL);
-    diskmodel_done();
 
-    return 0;
+
+//-----------------------------------------------------------------
+// model with default handle
+//-----------------------------------------------------------------
+
+
+int diskmodel_init(char *modellib, double M, double a, char* params)
+//! External disk model initialization.
+//! Loads the compiled library, links is into the program and calls its initialization routine. 
+//! All the required functions have to be declared in the library. The model is linked 
+//! to the default handle that is used by all `diskmodel_*` routines; only one such model 
+//! can be open at a time (use sim5_diskmodel_open() to work with more models).
+//!
+//! @param modellib  filesystem path to the library (string)
+//! @param M       mass of BH [Msun]
+//! @param a       spin of BH [0..1]
+//! @param params  parametres that are passed to the library initialization function
+//! 
+//! @result Return the result of the library's initialization function or -1 of the library could not 
+//! loaded or be initialized.
+{
+    if (diskmodel_default) {
+        fprintf(stderr, "diskmodel_init: cannot open '%s', close current model first\n", modellib);
+        return -1;
+    }
+
+    diskmodel_default = diskmodel_load(modellib, M, a);
+    if (!diskmodel_default) return -1;
+
+    return diskmodel_default->init(M, a, params);
+}
+
+
+
+void diskmodel_done()
+//! External disk model finitialization.
+//! Frees memory and unlinks the libraray.
+{
+    sim5_diskmodel_close(diskmodel_default);
+    diskmodel_default = NULL;
+}
+
+
+
+char* diskmodel_name()
+//! Model name.
+//! See sim5_diskmodel_name().
+{
+    return sim5_diskmodel_name(diskmodel_default);
+}
+
+
+
+double diskmodel_r_min()
+//! Minimal radius of the disk (disk inner edge).
+//! See sim5_diskmodel_r_min().
+//!
+//! @result Radius of disk inner edge [GM/c2]
+{
+    return sim5_diskmodel_r_min(diskmodel_default);
+}
+
+
+
+double diskmodel_mdot()
+//! Mass accretion rate.
+//! See sim5_diskmodel_mdot().
+//!
+//! @result Mass accretion rate in Eddington units.
+{
+    return sim5_diskmodel_mdot(diskmodel_default);
+}
+
+
+
+double diskmodel_lumi()
+//! Total disk luminosity.
+//! See sim5_diskmodel_lumi().
+//!
+//! @result Total disk luminosity of both surfaces [L_Edd]
+{
+    return sim5_diskmodel_lumi(diskmodel_default);
+}
+
+
+
+double diskmodel_flux(double R)
+//! Local flux from one side of the disk.
+//! See sim5_diskmodel_flux().
+//!
+//! @param R radius of emission [GM/c2]
+//!
+//! @result Total outgoing flux from unit area on one side of the disk [erg cm-2 s-1]. 
+{
+    return sim5_diskmodel_flux(diskmodel_default, R);
+}
+
+
+
+double diskmodel_sigma(double R)
+//! Column density.
+//! See sim5_diskmodel_sigma().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//!
+//! @result Midplane column density in [g/cm2].
+{
+    return sim5_diskmodel_sigma(diskmodel_default, R);
 }
-*/
 
+
+
+double diskmodel_ell(double R)
+//! Specific angular momentum.
+//! See sim5_diskmodel_ell().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//!
+//! @result Specific angular momentum in [g.u.].
+{
+    return sim5_diskmodel_ell(diskmodel_default, R);
+}
+
+
+
+double diskmodel_vr(double R)
+//! Radial velocity.
+//! See sim5_diskmodel_vr().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//!
+//! @result Radial velocity in [speed_of_light].
+{
+    return sim5_diskmodel_vr(diskmodel_default, R);
+}
+
+
+
+double diskmodel_h(double R)
+//! Surface height.
+//! See sim5_diskmodel_h().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//!
+//! @result Scale-height [rg].
+{
+    return sim5_diskmodel_h(diskmodel_default, R);
+}
+
+
+
+double diskmodel_dhdr(double R)
+//! Derivative of surface height.
+//! See sim5_diskmodel_dhdr().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//!
+//! @result Derivative of surface height.
+{
+    return sim5_diskmodel_dhdr(diskmodel_default, R);
+}
+
+
+
+double diskmodel_eval(double R, int quantity)
+//! Other quantity evaluation.
+//! See sim5_diskmodel_eval().
+//!
+//! @param R radius (measured in equatorial plane) [rg]
+//! @param quantity quantity identified code
+//!
+//! @result The value of the requested quantity.
+{
+    return sim5_diskmodel_eval(diskmodel_default, R, quantity);
+}
+
+
+
+void diskmodel_params(FILE* stream)
+//! Prints model parameters.
+//! See sim5_diskmodel_params().
+//!
+//! @param stream stream to write to
+{
+    sim5_diskmodel_params(diskmodel_default, stream);
+}
+
+
+
+void diskmodel_dump(char* filename)
+//! Prints the disk structure as a function of radius.
+//! See sim5_diskmodel_dump().
+//!
+//! @param filename Path to a file that should be written. If NULL then it prints to STDOUT. 
+{
+    sim5_diskmodel_dump(diskmodel_default, filename);
+}
+
+
+
+#undef DISKMODEL_CACHE_NQ
+#undef DISKMODEL_CACHED
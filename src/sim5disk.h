@@ -0,0 +1,121 @@
+//************************************************************************
+//    sim5disk.h - wrapper for external disk models
+//------------------------------------------------------------------------
+//    Date   : 2.10.2014
+//    Author : Michal Bursa
+//    e-mail : bursa@astro.cas.cz
+//------------------------------------------------------------------------
+//    (C) 2017 Michal Bursa
+//************************************************************************
+
+
+#ifndef _SIM5DISK_H
+#define _SIM5DISK_H
+
+#ifndef CUDA
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// version of the disk model library interface
+// - version 1: scalar functions (diskmodel_flux(R), diskmodel_sigma(R), ...)
+// - version 2: adds optional diskmodel_eval_batch(R[], n, quantity, out[])
+#define DISKMODEL_ABI_VERSION           2
+#define DISKMODEL_ABI_BATCH             2
+
+// standard quantities for sim5_diskmodel_eval_batch() and diskmodel_eval_batch();
+// (negative to not collide with model-specific quantity codes of diskmodel_eval())
+#define DISKMODEL_FLUX                  -1      // local flux [erg cm-2 s-1]
+#define DISKMODEL_SIGMA                 -2      // column density [g cm-2]
+#define DISKMODEL_ELL                   -3      // specific angular momentum [g.u.]
+#define DISKMODEL_VR                    -4      // radial velocity [speed_of_light]
+#define DISKMODEL_H                     -5      // surface height [rg]
+#define DISKMODEL_DHDR                  -6      // surface slope dH/dR
+
+// maximal number of simultaneously open models
+#define DISKMODEL_MAX_MODELS            32
+
+
+typedef struct sim5diskmodel {
+    int    id;                                              // model identifier (index in the registry)
+    char*  lib_path;                                        // path to the library
+    void*  lib_handle;                                      // handle of the linked library
+    int    abi_version;                                     // interface version provided by the library
+    double M;                                               // BH mass [M_sun]
+    double a;                                               // BH spin
+    int    (*init)(double M, double a, char* params);
+    void   (*done)();
+    char*  (*name)();
+    double (*r_min)();
+    double (*flux)(double R);
+    double (*lumi)();
+    double (*mdot)();
+    double (*sigma)(double R);
+    double (*ell)(double R);
+    double (*vr)(double R);
+    double (*h)(double R);
+    double (*dhdr)(double R);
+    double (*eval)(double R, int quantity);
+    void   (*params)(FILE* output);
+    void   (*eval_batch)(const double* R, int n, int quantity, double* out);   // optional (ABI>=2)
+
+    // cache of radial profiles (see sim5_diskmodel_cache())
+    int    cache_N;                                         // number of radial nodes (0 if cache is not used)
+    double cache_R_min;                                     // inner radius of the cache
+    double cache_R_max;                                     // outer radius of the cache
+    double cache_logR_min;                                  // log(cache_R_min)
+    double cache_dlogR_1;                                   // inverse step of the cache grid in log(R)
+    double* cache;                                          // tabulated standard quantities (6 values per node)
+} sim5diskmodel;
+
+
+// model with handle
+sim5diskmodel* sim5_diskmodel_open(char *modellib, double M, double a, char* params);
+void sim5_diskmodel_close(sim5diskmodel* model);
+sim5diskmodel* sim5_diskmodel_get(int id);
+int sim5_diskmodel_cache(sim5diskmodel* model, double R_max, int N);
+char* sim5_diskmodel_name(sim5diskmodel* model);
+double sim5_diskmodel_r_min(sim5diskmodel* model);
+double sim5_diskmodel_mdot(sim5diskmodel* model);
+double sim5_diskmodel_lumi(sim5diskmodel* model);
+double sim5_diskmodel_flux(sim5diskmodel* model, double R);
+double sim5_diskmodel_sigma(sim5diskmodel* model, double R);
+double sim5_diskmodel_ell(sim5diskmodel* model, double R);
+double sim5_diskmodel_vr(sim5diskmodel* model, double R);
+double sim5_diskmodel_h(sim5diskmodel* model, double R);
+double sim5_diskmodel_dhdr(sim5diskmodel* model, double R);
+double sim5_diskmodel_eval(sim5diskmodel* model, double R, int quantity);
+void sim5_diskmodel_eval_batch(sim5diskmodel* model, const double* R, int n, int quantity, double* out);
+void sim5_diskmodel_params(sim5diskmodel* model, FILE* stream);
+void sim5_diskmodel_dump(sim5diskmodel* model, char* filename);
+
+// model with default handle
+int diskmodel_init(char *modellib, double M, double a, char* params);
+void diskmodel_done();
+char* diskmodel_name();
+double diskmodel_r_min();
+double diskmodel_mdot();
+double diskmodel_lumi();
+double diskmodel_flux(double R);
+double diskmodel_sigma(double R);
+double diskmodel_ell(double R);
+double diskmodel_vr(double R);
+double diskmodel_h(double R);
+double diskmodel_dhdr(double R);
+double diskmodel_eval(double R, int quantity);
+void diskmodel_params(FILE* stream);
+void diskmodel_dump(char* filename);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CUDA
+
+#endif
+
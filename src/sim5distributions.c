@@ -18,12 +18,90 @@
 
 #ifndef CUDA
 
+//! \cond SKIP
+// 5-point Gauss-Legendre rule on [-1,1]
+static const double distrib_gl_x[5] = {-0.9061798459386640, -0.5384693101056831, 0.0, 0.5384693101056831, 0.9061798459386640};
+static const double distrib_gl_w[5] = { 0.2369268850561891,  0.4786286704993665, 0.5688888888888889, 0.4786286704993665, 0.2369268850561891};
+
+
+DEVICEFUNC static
+void distrib_nodes(double* x, long N, double x_min, double x_max)
+// sets x[] points as Chebyshev-Lobatto nodes, which are denser towards the boundaries
+// (like nodes of gauss-legendre quadrature formula used before, but they have a closed form)
+// this is better than linear distrubution as it helps to dump unwanted
+// spline oscillations
+{
+    long i;
+    for (i=0; i<N; i++) x[i] = 0.5*(x_min+x_max) - 0.5*(x_max-x_min)*cos(M_PI*(double)(i)/(double)(N-1));
+    x[0] = x_min;
+    x[N-1] = x_max;
+}
+
+
+DEVICEFUNC static
+double distrib_normalize(double* cdf, double* pdf, long N)
+// normalizes cummulative distribution (and optionally PDF) by its last value and returns the norm;
+// distribution with zero norm is replaced by a uniform one
+{
+    long i;
+    double norm = cdf[N-1];
+    if (norm > 0.0) {
+        for (i=0; i<N; i++) cdf[i] /= norm;
+        if (pdf) for (i=0; i<N; i++) pdf[i] /= norm;
+    } else {
+        for (i=0; i<N; i++) cdf[i] = (double)(i)/(double)(N-1);
+    }
+    cdf[N-1] = 1.0;
+    return norm;
+}
+
+
+DEVICEFUNC static
+void distrib_guide(const double* cdf, long N, long* guide, long guide_n)
+// guide table: guide[j] is the grid interval that contains the CDF value j/guide_n,
+// so that the interval for a given CDF value is found by a short walk from there
+{
+    long i, j;
+    for (i=0, j=0; j<guide_n; j++) {
+        double u = (double)(j)/(double)(guide_n);
+        while ((i < N-2) && (cdf[i+1] <= u)) i++;
+        guide[j] = i;
+    }
+}
+
+
+DEVICEFUNC INLINE static
+double distrib_invert(const double* x, const double* c, long N, const long* guide, long guide_n, double u, long* interval)
+// inverse cummulative distribution: interval is located with the guide table,
+// the value within the interval is interpolated linearly;
+// index of the interval is optionally returned in `interval`
+{
+    long j = (long)(u*guide_n);
+    long i;
+    double dc;
+
+    if (j < 0) j = 0;
+    if (j >= guide_n) j = guide_n-1;
+    i = guide[j];
+    while ((i < N-2) && (c[i+1] <= u)) i++;
+    if (interval) *interval = i;
+
+    dc = c[i+1] - c[i];
+    return (dc > 0.0) ? x[i] + (u - c[i])/dc*(x[i+1] - x[i]) : x[i];
+}
+//! \endcond
+
+
+
 DEVICEFUNC
 void distrib_init(sim5distrib* d, double(*pdf)(double), double x_min, double x_max, int N)
 //! Creates a distribution based on given probability density function (PDF).
 //!
 //! Uses given probability density function to initiate the internal data structure with
 //! calculated cummulative distribution and its inverse.
+//! The cummulative distribution is built in a single pass over the grid: the PDF is integrated
+//! over each grid interval with a 5-point Gauss-Legendre rule and the partial integrals are summed up,
+//! which takes 6N evaluations of the PDF and O(N) operations. A guide table is then made for drawing values in constant time.
 //!
 //! @param d pointer to structure that stores the disribution data
 //! @param pdf pointer to probability density function
@@ -31,47 +109,65 @@ void distrib_init(sim5distrib* d, double(*pdf)(double), double x_min, double x_m
 //! @param x_min right boundary for x
 //! @param N number of samples to take over the interval [x_min:x_max]
 {
-    int i;
-    double *tmp_x = (double*)calloc(N, sizeof(double));
-    double *tmp_w = (double*)calloc(N, sizeof(double));
-    double *tmp_pdf = (double*)calloc(N, sizeof(double));
-    double *tmp_cdf = (double*)calloc(N, sizeof(double));
+    int i, k;
+    sim5arena* arena = sim5_arena_current();
+
+    // temporary arrays are taken by malloc, as they are released while the persistent data made
+    // from them (below) stay in the arena, so the arena could not reuse their space
+    double *tmp_x = (double*)malloc(N*sizeof(double));
+    double *tmp_pdf = (double*)malloc(N*sizeof(double));
+    double *tmp_cdf = (double*)malloc(N*sizeof(double));
+
+    if ((!tmp_x) || (!tmp_pdf) || (!tmp_cdf)) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "distrib_init", "memory allocation failure (N=%d)", N);
+        free(tmp_cdf);
+        free(tmp_pdf);
+        free(tmp_x);
+        memset(d, 0, sizeof(sim5distrib));
+        return;
+    }
+
+    SIM5_TIMER_START(SIM5_TIMER_DISTRIB_INIT);
 
     d->x_min = x_min;
     d->x_max = x_max;
-    d->norm  = integrate_simpson(pdf, x_min, x_max, 1e-5);
+    d->arena = arena;
 
-    // the x_min point
-    tmp_x[0]   = x_min;
+    distrib_nodes(tmp_x, N, x_min, x_max);
+
+    // PDF at nodes and its cummulative integral over grid intervals
     tmp_pdf[0] = pdf(x_min);
     tmp_cdf[0] = 0.0;
-
-    // set x[] points as nodes of gauss-legendre quadrature formula
-    // this is better than linear distrubution as it helps to dump unwanted
-    // spline oscillations
-    gauleg(x_min, x_max, &tmp_x[1], tmp_w, N-2);
-
-    // middle points
-    for (i=1; i<N-1; i++) {
-        //we have tmp_x[] already from gauleg(); for linear distibution it is: tmp_x[i]   = x_min + (double)(i)*(x_max-x_min)/(double)(N-1);
-        tmp_pdf[i] = pdf(tmp_x[i])/d->norm;
-        tmp_cdf[i] = integrate_simpson(pdf, x_min, tmp_x[i], 1e-6)/d->norm;
-        if ((i>1) && (tmp_cdf[i]<tmp_cdf[i-1])) fprintf(stderr, "CDF problem at %d/%d (%e  %e)\n", i,N,tmp_cdf[i],tmp_cdf[i-1]);
+    for (i=1; i<N; i++) {
+        double xc = 0.5*(tmp_x[i]+tmp_x[i-1]);
+        double hw = 0.5*(tmp_x[i]-tmp_x[i-1]);
+        double sum = 0.0;
+        for (k=0; k<5; k++) sum += distrib_gl_w[k]*pdf(xc + hw*distrib_gl_x[k]);
+        tmp_pdf[i] = pdf(tmp_x[i]);
+        tmp_cdf[i] = tmp_cdf[i-1] + sum*hw;
     }
 
-    // the x_max point
-    tmp_x[N-1]   = x_max;
-    tmp_pdf[N-1] = pdf(x_max);
-    tmp_cdf[N-1] = 1.0;
+    // normalization
+    d->norm = distrib_normalize(tmp_cdf, tmp_pdf, N);
 
     sim5_interp_init(&d->pdf, tmp_x, tmp_pdf, N, INTERP_DATA_COPY, INTERP_TYPE_LINLIN, 0);
     sim5_interp_init(&d->cdf, tmp_x, tmp_cdf, N, INTERP_DATA_COPY, INTERP_TYPE_LINLIN, 0);
-    sim5_interp_init(&d->icd, tmp_cdf, tmp_x, N, INTERP_DATA_COPY, INTERP_TYPE_LINLIN, 0);
 
-    free(tmp_x);
-    free(tmp_w);
-    free(tmp_pdf);
+    // guide table for the inverse of the cummulative distribution
+    d->guide_n = N;
+    d->guide = (long*)sim5_arena_malloc(arena, d->guide_n*sizeof(long));
+    if ((d->guide) && (d->cdf.N > 0) && (d->pdf.N > 0)) {
+        distrib_guide(tmp_cdf, N, d->guide, d->guide_n);
+    } else {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "distrib_init", "memory allocation failure (N=%d)", N);
+        distrib_done(d);
+    }
+
     free(tmp_cdf);
+    free(tmp_pdf);
+    free(tmp_x);
+
+    SIM5_TIMER_STOP(SIM5_TIMER_DISTRIB_INIT);
 }
 
 
@@ -82,10 +178,23 @@ void distrib_done(sim5distrib* d)
 //!
 //! @param d pointer to structure that stores the disribution data
 {
-    sim5_interp_done(&d->pdf);
+    sim5_arena_free(d->arena, d->guide);
     sim5_interp_done(&d->cdf);
-    sim5_interp_done(&d->icd);
+    sim5_interp_done(&d->pdf);
+    d->guide = NULL;
+    d->guide_n = 0;
+}
+
+
+
+//! \cond SKIP
+DEVICEFUNC INLINE static
+double distrib_icd(sim5distrib* d, double u)
+// inverse cummulative distribution
+{
+    return distrib_invert(d->cdf.X, d->cdf.Y, d->cdf.N, d->guide, d->guide_n, u, NULL);
 }
+//! \endcond
 
 
 
@@ -95,12 +204,185 @@ double distrib_hit(sim5distrib* d)
 //!
 //! With the help of precomputed cummulative distribution function it generates
 //! a value form the interval [x_min:x_max] and returns this value.
+//! The interval of the inverse cummulative distribution is found with a guide table in constant expected time.
 //!
 //! @param d pointer to structure that stores the disribution data
 //!
 //! @result value from the distribution
 {
-    return sim5_interp_eval(&d->icd, sim5urand());
+    return distrib_icd(d, sim5urand());
+}
+
+
+
+DEVICEFUNC
+void distrib_hit_n(sim5distrib* d, double* x, size_t n)
+//! Generates an array of values according to the distribution.
+//!
+//! Bulk version of distrib_hit(). The uniform numbers are drawn at once
+//! with sim5_urand_fill() and then mapped through the inverse cummulative distribution.
+//!
+//! @param d pointer to structure that stores the disribution data
+//! @param x output array of values
+//! @param n number of values
+{
+    size_t i;
+    sim5_urand_fill(x, n);
+    for (i=0; i<n; i++) x[i] = distrib_icd(d, x[i]);
+}
+
+
+
+DEVICEFUNC
+void distrib2d_init(sim5distrib2d* d, double(*pdf)(double,double), double x_min, double x_max, int Nx, double y_min, double y_max, int Ny)
+//! Creates a two-dimensional distribution based on given joint probability density function (PDF).
+//!
+//! Uses given joint PDF p(x,y) to make a table of the marginal cummulative distribution in x and
+//! of the conditional cummulative distributions of y, one for each x-interval of the grid.
+//! A pair (x,y) is then drawn by taking x from the marginal distribution and y from
+//! the conditional distribution that belongs to the grid interval of x. The grids are set up
+//! the same way as in distrib_init() and the PDF is integrated over each grid cell with
+//! a 5x5-point Gauss-Legendre rule, which takes 25(Nx-1)(Ny-1) evaluations of the PDF.
+//! The joint density is thus represented as piecewise constant on the grid cells.
+//!
+//! All tables are kept in one memory block, which is not modified after initialization, so
+//! the distribution can be shared by several threads (with distrib2d_icd() and thread's own
+//! random numbers).
+//!
+//! @param d pointer to structure that stores the disribution data
+//! @param pdf pointer to joint probability density function p(x,y)
+//! @param x_min left boundary for x
+//! @param x_max right boundary for x
+//! @param Nx number of samples to take over the interval [x_min:x_max]
+//! @param y_min left boundary for y
+//! @param y_max right boundary for y
+//! @param Ny number of samples to take over the interval [y_min:y_max]
+{
+    long i, j;
+    int kx, ky;
+    sim5arena* arena = sim5_arena_current();
+    size_t size_d = (size_t)(Nx + Ny + Nx + (Nx-1)*Ny)*sizeof(double);
+    size_t size_l = (size_t)(Nx + (Nx-1)*Ny)*sizeof(long);
+    char* data = (char*)sim5_arena_malloc(arena, size_d + size_l);
+
+    if (!data) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "distrib2d_init", "memory allocation failure (Nx=%d, Ny=%d)", Nx, Ny);
+        memset(d, 0, sizeof(sim5distrib2d));
+        return;
+    }
+
+    d->arena = arena;
+    d->x_min = x_min;
+    d->x_max = x_max;
+    d->y_min = y_min;
+    d->y_max = y_max;
+    d->Nx = Nx;
+    d->Ny = Ny;
+    d->data    = data;
+    d->x       = (double*)(data);
+    d->y       = d->x + Nx;
+    d->cdf_x   = d->y + Ny;
+    d->cdf_y   = d->cdf_x + Nx;
+    d->guide_x = (long*)(data + size_d);
+    d->guide_y = d->guide_x + Nx;
+
+    distrib_nodes(d->x, Nx, x_min, x_max);
+    distrib_nodes(d->y, Ny, y_min, y_max);
+
+    // integrate PDF over grid cells; for each x-interval the cummulative sum over y-intervals
+    // gives the conditional distribution and its total gives the marginal one
+    d->cdf_x[0] = 0.0;
+    for (i=0; i<Nx-1; i++) {
+        double* cdf_y = d->cdf_y + i*Ny;
+        double xc = 0.5*(d->x[i+1]+d->x[i]);
+        double xw = 0.5*(d->x[i+1]-d->x[i]);
+        cdf_y[0] = 0.0;
+        for (j=0; j<Ny-1; j++) {
+            double yc = 0.5*(d->y[j+1]+d->y[j]);
+            double yw = 0.5*(d->y[j+1]-d->y[j]);
+            double sum = 0.0;
+            for (kx=0; kx<5; kx++) for (ky=0; ky<5; ky++) {
+                sum += distrib_gl_w[kx]*distrib_gl_w[ky]*pdf(xc + xw*distrib_gl_x[kx], yc + yw*distrib_gl_x[ky]);
+            }
+            cdf_y[j+1] = cdf_y[j] + sum*xw*yw;
+        }
+        d->cdf_x[i+1] = d->cdf_x[i] + cdf_y[Ny-1];
+        distrib_normalize(cdf_y, NULL, Ny);
+        distrib_guide(cdf_y, Ny, d->guide_y + i*Ny, Ny);
+    }
+
+    d->norm = distrib_normalize(d->cdf_x, NULL, Nx);
+    distrib_guide(d->cdf_x, Nx, d->guide_x, Nx);
+}
+
+
+
+DEVICEFUNC
+void distrib2d_done(sim5distrib2d* d)
+//! Frees the internal data for the two-dimensional distribution.
+//!
+//! @param d pointer to structure that stores the disribution data
+{
+    sim5_arena_free(d->arena, d->data);
+    d->data = NULL;
+    d->x = d->y = d->cdf_x = d->cdf_y = NULL;
+    d->guide_x = d->guide_y = NULL;
+}
+
+
+
+DEVICEFUNC
+void distrib2d_icd(const sim5distrib2d* d, double u, double v, double* x, double* y)
+//! Maps a pair of uniform numbers to a pair of values from the two-dimensional distribution.
+//!
+//! Inverse of the cummulative distribution: `u` gives x from the marginal distribution
+//! and `v` gives y from the conditional distribution for that x. The function only reads
+//! the distribution data.
+//!
+//! @param d pointer to structure that stores the disribution data
+//! @param u uniform number from interval [0:1) for x
+//! @param v uniform number from interval [0:1) for y
+//! @param x output value of x
+//! @param y output value of y
+{
+    long i;
+    *x = distrib_invert(d->x, d->cdf_x, d->Nx, d->guide_x, d->Nx, u, &i);
+    *y = distrib_invert(d->y, d->cdf_y + i*d->Ny, d->Ny, d->guide_y + i*d->Ny, d->Ny, v, NULL);
+}
+
+
+
+DEVICEFUNC
+void distrib2d_hit(const sim5distrib2d* d, double* x, double* y)
+//! Generates a pair of values according to the two-dimensional distribution.
+//!
+//! @param d pointer to structure that stores the disribution data
+//! @param x output value of x
+//! @param y output value of y
+{
+    double u = sim5urand();
+    double v = sim5urand();
+    distrib2d_icd(d, u, v, x, y);
+}
+
+
+
+DEVICEFUNC
+void distrib2d_hit_n(const sim5distrib2d* d, double* x, double* y, size_t n)
+//! Generates arrays of value pairs according to the two-dimensional distribution.
+//!
+//! Bulk version of distrib2d_hit(). The uniform numbers are drawn at once
+//! with sim5_urand_fill() and then mapped through the inverse cummulative distribution.
+//!
+//! @param d pointer to structure that stores the disribution data
+//! @param x output array of x values
+//! @param y output array of y values
+//! @param n number of value pairs
+{
+    size_t i;
+    sim5_urand_fill(x, n);
+    sim5_urand_fill(y, n);
+    for (i=0; i<n; i++) distrib2d_icd(d, x[i], y[i], &x[i], &y[i]);
 }
 
 #endif
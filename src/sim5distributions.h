@@ -26,14 +26,42 @@ typedef struct sim5distrib {
     double norm;
     sim5interp pdf;                     // probability distribution function
     sim5interp cdf;                     // cummulative distribution function
-    sim5interp icd;                     // inverse cummulative distribution function
+    long  guide_n;                      // size of guide table
+    long* guide;                        // guide table for inverse of cummulative distribution function
+    sim5arena* arena;                   // arena the data are allocated from (or NULL for malloc)
 } sim5distrib;
 
 
+typedef struct sim5distrib2d {
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+    double norm;
+    long Nx;                            // number of grid nodes in x
+    long Ny;                            // number of grid nodes in y
+    double* x;                          // grid nodes in x [Nx]
+    double* y;                          // grid nodes in y [Ny]
+    double* cdf_x;                      // marginal cummulative distribution in x [Nx]
+    double* cdf_y;                      // conditional cummulative distributions in y, one row per x-interval [(Nx-1)*Ny]
+    long* guide_x;                      // guide table for the marginal distribution [Nx]
+    long* guide_y;                      // guide tables for the conditional distributions [(Nx-1)*Ny]
+    void* data;                         // single memory block that holds all the arrays above
+    sim5arena* arena;                   // arena the data are allocated from (or NULL for malloc)
+} sim5distrib2d;
+
+
 
 DEVICEFUNC void distrib_init(sim5distrib* d, double(*pdf)(double), double x_min, double x_max, int N);
 DEVICEFUNC void distrib_done(sim5distrib* d);
 DEVICEFUNC INLINE double distrib_hit(sim5distrib* d);
+DEVICEFUNC void distrib_hit_n(sim5distrib* d, double* x, size_t n);
+
+DEVICEFUNC void distrib2d_init(sim5distrib2d* d, double(*pdf)(double,double), double x_min, double x_max, int Nx, double y_min, double y_max, int Ny);
+DEVICEFUNC void distrib2d_done(sim5distrib2d* d);
+DEVICEFUNC void distrib2d_icd(const sim5distrib2d* d, double u, double v, double* x, double* y);
+DEVICEFUNC void distrib2d_hit(const sim5distrib2d* d, double* x, double* y);
+DEVICEFUNC void distrib2d_hit_n(const sim5distrib2d* d, double* x, double* y, size_t n);
 
 #ifdef __cplusplus
 }
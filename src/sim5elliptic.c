@@ -30,10 +30,12 @@ double rf(double x, double y, double z)
         #endif
 	}
 
+	SIM5_COUNT(SIM5_STAT_ELLIPTIC_CALL);
 	xt=x;
 	yt=y;
 	zt=z;
 	do {
+		SIM5_COUNT(SIM5_STAT_ELLIPTIC_ITER);
 		sqrtx=sqrt(xt);
 		sqrty=sqrt(yt);
 		sqrtz=sqrt(zt);
@@ -68,12 +70,14 @@ double rd(double x, double y, double z) {
         #endif
 	}
 
+	SIM5_COUNT(SIM5_STAT_ELLIPTIC_CALL);
 	xt=x;
 	yt=y;
 	zt=z;
 	sum=0.0;
 	fac=1.0;
 	do {
+		SIM5_COUNT(SIM5_STAT_ELLIPTIC_ITER);
 		sqrtx=sqrt(xt);
 		sqrty=sqrt(yt);
 		sqrtz=sqrt(zt);
@@ -117,6 +121,7 @@ double rc(double x, double y) {
         #endif
 	}
 
+	SIM5_COUNT(SIM5_STAT_ELLIPTIC_CALL);
 	if (y > 0.0) {
 		xt=x;
 		yt=y;
@@ -127,6 +132,7 @@ double rc(double x, double y) {
 		w=sqrt(x)/sqrt(xt);
 	}
 	do {
+		SIM5_COUNT(SIM5_STAT_ELLIPTIC_ITER);
 		alamb=2.0*sqrt(xt)*sqrt(yt)+yt;
 		xt=0.25*(xt+alamb);
 		yt=0.25*(yt+alamb);
@@ -156,6 +162,7 @@ double rj(double x, double y, double z, double p) {
         return 0.0;
 	}
 
+	SIM5_COUNT(SIM5_STAT_ELLIPTIC_CALL);
     a=b=rcx=0.0;
 	sum=0.0;
 	fac=1.0;
@@ -176,6 +183,7 @@ double rj(double x, double y, double z, double p) {
 		rcx=rc(rho,tau);
 	}
 	do {
+		SIM5_COUNT(SIM5_STAT_ELLIPTIC_ITER);
 		sqrtx=sqrt(xt);
 		sqrty=sqrt(yt);
 		sqrtz=sqrt(zt);
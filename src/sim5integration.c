@@ -19,12 +19,41 @@
 //! \cond SKIP
 #define NMAX_TRAPEZOID 23
 #define NMAX_SIMPSON 23
+#define NMAX_GK15 100
+//! \endcond
+
+
+//! \cond SKIP
+#ifdef CUDA
+#define INTEGRATE_CHUNK 16
+#else
+#define INTEGRATE_CHUNK 256
+#endif
+
+// adaptors that turn a plain integrand into a context-carrying one
+// and a context-carrying integrand into a batch one
+struct integrate_plain { double (*f)(double); };
+struct integrate_scalar { double (*f)(double, void*); void* ctx; };
+
+DEVICEFUNC static
+double integrate_plain_call(double x, void* ctx)
+{
+    return ((struct integrate_plain*)ctx)->f(x);
+}
+
+DEVICEFUNC static
+void integrate_scalar_call(const double x[], double y[], long n, void* ctx)
+{
+    struct integrate_scalar* w = (struct integrate_scalar*)ctx;
+    long i;
+    for (i=0; i<n; i++) y[i] = w->f(x[i], w->ctx);
+}
 //! \endcond
 
 
 //! \cond SKIP
 DEVICEFUNC 
-static void integrate_trapezoid_rule(double(*f)(double), double a, double b, int n, double *s)
+static void integrate_trapezoid_rule(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, int n, double *s)
 //! Integration core routine based on trapezoid rule
 //! - computes the `n`-th stage of refinement of an extended trapezoidal rule for function
 //!   <f> and limits `a` and `b`
@@ -35,20 +64,29 @@ static void integrate_trapezoid_rule(double(*f)(double), double a, double b, int
 //! - implementation is based on Numerical Recipes with the improvement by GSL,
 //!   where a varible pointer is passed to the routine to store the value of 
 //!   the latest refinement instead of that being a global variable
+//! - new points of a refinement stage are passed to the integrand in batches of INTEGRATE_CHUNK
 //! - calling scheme:
-//!   `for(j=1; j<=M+1; j++) trapezoid_rule(func, a, b, j, &answer);`
+//!   `for(j=1; j<=M+1; j++) trapezoid_rule(func, ctx, a, b, j, &answer);`
 {
-    double x, tnm, sum, del;
-    int it, j;
+    double x[INTEGRATE_CHUNK], y[INTEGRATE_CHUNK];
+    double tnm, sum, del;
+    long it, j, i, m;
 
     if(n==1){
-        *s = 0.5 * (b-a) * (f(b) + f(a));
+        x[0] = a;
+        x[1] = b;
+        f(x, y, 2, ctx);
+        *s = 0.5 * (b-a) * (y[0] + y[1]);
     } else {
         for(it=1, j=1; j < n-1; j++)  it <<= 1;
         tnm = (double) it;
         del = (b-a) / tnm;
-        x = a + 0.5 * del;
-        for(sum=0.0, j=1; j<=it; j++, x+=del) { sum += f(x); }
+        for(sum=0.0, j=0; j<it; j+=m) {
+            m = (it-j < INTEGRATE_CHUNK) ? it-j : INTEGRATE_CHUNK;
+            for (i=0; i<m; i++) x[i] = a + ((double)(j+i) + 0.5) * del;
+            f(x, y, m, ctx);
+            for (i=0; i<m; i++) sum += y[i];
+        }
         *s = 0.5 * (*s + del * sum);
     }
 }
@@ -70,15 +108,57 @@ double integrate_trapezoid(double(*f)(double), double a, double b, double acc)
 //! @param acc relative accuracy of integration
 //!
 //! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_plain w = {f};
+    return integrate_trapezoid_ctx(integrate_plain_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_trapezoid_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc)
+//! Integral of a function with context using trapezoid rule.
+//! Same as integrate_trapezoid(), but the integrand receives a user pointer `ctx`
+//! with its parameters, so no nested function is needed to pass them.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its second argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_scalar w = {f, ctx};
+    return integrate_trapezoid_batch(integrate_scalar_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_trapezoid_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc)
+//! Integral of a batch function using trapezoid rule.
+//! Same as integrate_trapezoid_ctx(), but the integrand evaluates a whole array of abscissae
+//! `x[0..n-1]` in one call and stores the values to `y[0..n-1]`. All new points of a refinement 
+//! step are passed at once (in batches of at most 256 points), which allows the integrand 
+//! to vectorize its evaluation.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its last argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
 {
     int n;
     double s = 0.0;
     double olds = DBL_MIN;  // any number that is unlikely to be the average of the function at its endpoints is ok
 
     for (n=1; n<=NMAX_TRAPEZOID; n++) {
-        integrate_trapezoid_rule(f, a, b, n, &s);
+        integrate_trapezoid_rule(f, ctx, a, b, n, &s);
         if (n > 3) {        // avoid spurious early convergence
-            if ((fabs(s-olds) < acc*abs(olds)) || ((s==0.) && (olds==0.))) return s;
+            if ((fabs(s-olds) < acc*fabs(olds)) || ((s==0.) && (olds==0.))) return s;
         }
         olds = s;
     }
@@ -109,6 +189,47 @@ double integrate_simpson(double (*f)(double), double a, double b, double acc)
 //! @param acc relative accuracy of integration
 //!
 //! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_plain w = {f};
+    return integrate_simpson_ctx(integrate_plain_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_simpson_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc)
+//! Integral of a function with context using Simpson rule.
+//! Same as integrate_simpson(), but the integrand receives a user pointer `ctx`
+//! with its parameters, so no nested function is needed to pass them.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its second argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_scalar w = {f, ctx};
+    return integrate_simpson_batch(integrate_scalar_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_simpson_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc)
+//! Integral of a batch function using Simpson rule.
+//! Same as integrate_simpson_ctx(), but the integrand evaluates a whole array of abscissae
+//! `x[0..n-1]` in one call and stores the values to `y[0..n-1]` 
+//! (see integrate_trapezoid_batch()).
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its last argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
 {
     int n;
     double s, st=0.0, ost, os;
@@ -116,7 +237,7 @@ double integrate_simpson(double (*f)(double), double a, double b, double acc)
     ost = os = -1.e50;
 
     for (n=1; n<=NMAX_SIMPSON; n++){
-        integrate_trapezoid_rule(f, a, b, n, &st);
+        integrate_trapezoid_rule(f, ctx, a, b, n, &st);
         s = (4.*st - ost) / 3.;
         if (n > 3) {        // avoid spurious early convergence
             if ((fabs(s-os) < acc*fabs(os)) || ((s==0.) && (os==0.))) return s;
@@ -133,6 +254,193 @@ double integrate_simpson(double (*f)(double), double a, double b, double acc)
 }
 
 
+
+#ifndef CUDA
+//! \cond SKIP
+// Gauss-Kronrod 7-15 rule (abscissae of the Kronrod rule and weights of both rules, QUADPACK qk15)
+static const double integrate_gk15_x[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const double integrate_gk15_wk[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double integrate_gk15_wg[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+
+DEVICEFUNC static
+void integrate_gk15_nodes(double a, double b, double x[15])
+// abscissae of the rule on [a,b]: x[0] is the center, x[2j+1] and x[2j+2] are the pair
+// of points symmetric to the center with the Kronrod abscissa integrate_gk15_x[j]
+{
+    double c = 0.5*(a+b);
+    double h = 0.5*(b-a);
+    int j;
+    x[0] = c;
+    for (j=0; j<7; j++) {
+        x[2*j+1] = c - h*integrate_gk15_x[j];
+        x[2*j+2] = c + h*integrate_gk15_x[j];
+    }
+}
+
+
+DEVICEFUNC static
+double integrate_gk15_rule(double a, double b, const double y[15], double* err)
+// Kronrod estimate of the integral over [a,b] from functional values at integrate_gk15_nodes()
+// with the error estimate made from the difference to the embedded Gauss rule (QUADPACK scaling)
+{
+    double h = 0.5*(b-a);
+    double rk = integrate_gk15_wk[7]*y[0];
+    double rg = integrate_gk15_wg[3]*y[0];
+    double resabs = fabs(rk);
+    double mean, resasc, e;
+    int j;
+
+    for (j=0; j<7; j++) {
+        double fsum = y[2*j+1] + y[2*j+2];
+        rk += integrate_gk15_wk[j]*fsum;
+        resabs += integrate_gk15_wk[j]*(fabs(y[2*j+1]) + fabs(y[2*j+2]));
+        if (j&1) rg += integrate_gk15_wg[j/2]*fsum;
+    }
+
+    mean = 0.5*rk;
+    resasc = integrate_gk15_wk[7]*fabs(y[0]-mean);
+    for (j=0; j<7; j++) resasc += integrate_gk15_wk[j]*(fabs(y[2*j+1]-mean) + fabs(y[2*j+2]-mean));
+
+    e = fabs((rk-rg)*h);
+    resasc *= fabs(h);
+    if ((resasc != 0.0) && (e != 0.0)) e = resasc * fmin(1.0, pow(200.0*e/resasc, 1.5));
+    if (resabs*fabs(h) > DBL_MIN/(50.*DBL_EPSILON)) e = fmax(e, 50.*DBL_EPSILON*resabs*fabs(h));
+
+    *err = e;
+    return rk*h;
+}
+//! \endcond
+
+
+DEVICEFUNC 
+double integrate_gk15(double (*f)(double), double a, double b, double acc)
+//! Integral of a function using adaptive Gauss-Kronrod rule.
+//! Computes the integral \f$ \int^a_b f(x) dx \f$ with the 7-point Gauss and 15-point Kronrod rule 
+//! on a set of subintervals. The subinterval with the largest error estimate is bisected until 
+//! the total estimated error is smaller than `acc` times the integral or the maximum 
+//! number of subintervals (NMAX_GK15) is reached.
+//! The method converges much faster than integrate_simpson() for smooth functions and copes
+//! well with integrable end-point singularities as no function values at end points are used.
+//! The GK15 routines are host-only (they are not compiled for CUDA device code).
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_plain w = {f};
+    return integrate_gk15_ctx(integrate_plain_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_gk15_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc)
+//! Integral of a function with context using adaptive Gauss-Kronrod rule.
+//! Same as integrate_gk15(), but the integrand receives a user pointer `ctx`
+//! with its parameters, so no nested function is needed to pass them.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its second argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
+{
+    struct integrate_scalar w = {f, ctx};
+    return integrate_gk15_batch(integrate_scalar_call, &w, a, b, acc);
+}
+
+
+
+DEVICEFUNC 
+double integrate_gk15_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc)
+//! Integral of a batch function using adaptive Gauss-Kronrod rule.
+//! Same as integrate_gk15_ctx(), but the integrand evaluates a whole array of abscissae
+//! `x[0..n-1]` in one call and stores the values to `y[0..n-1]`. The 30 abscissae of both
+//! halves of a bisected subinterval are passed at once.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its last argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param acc relative accuracy of integration
+//!
+//! @result Integral of the function over the interval [a,b].
+{
+    double ia[NMAX_GK15], ib[NMAX_GK15], ir[NMAX_GK15], ie[NMAX_GK15];
+    double x[30], y[30];
+    double result, error;
+    int n = 1;
+    int i, k;
+
+    integrate_gk15_nodes(a, b, x);
+    f(x, y, 15, ctx);
+    ia[0] = a;
+    ib[0] = b;
+    ir[0] = result = integrate_gk15_rule(a, b, y, &ie[0]);
+    error = ie[0];
+
+    while (error > acc*fabs(result)) {
+        double m;
+
+        if (n == NMAX_GK15) {
+            #ifndef CUDA
+            warning("too many steps in integrate_gk15()");
+            #endif
+            break;
+        }
+
+        // bisect the subinterval with the largest error
+        for (k=0, i=1; i<n; i++) if (ie[i] > ie[k]) k = i;
+        m = 0.5*(ia[k]+ib[k]);
+        integrate_gk15_nodes(ia[k], m, x);
+        integrate_gk15_nodes(m, ib[k], x+15);
+        f(x, y, 30, ctx);
+
+        ia[n] = m;
+        ib[n] = ib[k];
+        ir[n] = integrate_gk15_rule(m, ib[k], y+15, &ie[n]);
+        ib[k] = m;
+        ir[k] = integrate_gk15_rule(ia[k], m, y, &ie[k]);
+        n++;
+
+        // sum up from scratch to avoid accumulation of roundoff errors
+        for (result=0.0, error=0.0, i=0; i<n; i++) {
+            result += ir[i];
+            error  += ie[i];
+        }
+
+        if (fabs(ib[k]-ia[k]) <= 100.*DBL_EPSILON*fmax(fabs(ia[k]),fabs(ib[k]))) {
+            #ifndef CUDA
+            warning("roundoff limit reached in integrate_gk15()");
+            #endif
+            break;
+        }
+    }
+
+    return result;
+}
+#endif
+
+
 //-------------------------------------------------------------------------------------
 
 //! \cond SKIP
@@ -159,6 +467,90 @@ double gammln(double xx)
 
 
 
+//! \cond SKIP
+// cache of Gauss-Legendre rules on [-1,1] for orders 1..GAULEG_MAX_ORDER;
+// each entry holds n abscissae followed by n weights
+#define GAULEG_MAX_ORDER 1024
+
+#ifndef CUDA
+static double* gauleg_cache[GAULEG_MAX_ORDER+1];
+#endif
+
+
+DEVICEFUNC static
+void gauleg_compute(double x[], double w[], int n)
+// computes abscissae (in ascending order) and weights of n-point Gauss-Legendre rule on [-1,1]
+// by Newton iteration for the roots of Legendre polynomial
+{
+    const double EPS = 1e-15;
+	int m,j,i,iter;
+	double z1,z,pp,p3,p2,p1;
+
+	m=(n+1)/2;
+	for (i=1;i<=m;i++) {
+		z=cos(M_PI*(i-0.25)/(n+0.5));
+		for (iter=0; iter<100; iter++) {
+			p1=1.0;
+			p2=0.0;
+			for (j=1;j<=n;j++) {
+				p3=p2;
+				p2=p1;
+				p1=((2.0*j-1.0)*z*p2-(j-1.0)*p3)/j;
+			}
+			pp=n*(z*p1-p2)/(z*z-1.0);
+			z1=z;
+			z=z1-p1/pp;
+			if (fabs(z-z1) <= EPS) break;
+		}
+		x[i-1]=-z;
+		x[n+1-i-1]=+z;
+		w[i-1]=2.0/((1.0-z*z)*pp*pp);
+		w[n+1-i-1]=w[i-1];
+	}
+}
+//! \endcond
+
+
+
+#ifndef CUDA
+DEVICEFUNC
+const double* gauleg_rule(int n)
+//! Cached Gauss-Legendre rule.
+//! Returns abscissas and weights of the n-point Gauss-Legendre quadrature formula 
+//! on interval [-1,1]. The rule is computed on the first request for given order 
+//! and kept for the lifetime of the process, so subsequent requests cost nothing.
+//! The routine is thread-safe (concurrent callers may compute the rule in parallel, 
+//! but only one copy is published and the others are discarded).
+//!
+//! @param n number of quandrature points (1..1024)
+//!
+//! @result Pointer to an array of 2n values: n abscissas (in ascending order) followed 
+//! by n weights, or NULL if n is out of range. The array must not be modified or freed.
+{
+    double* rule;
+    double* new_rule;
+
+    if ((n < 1) || (n > GAULEG_MAX_ORDER)) return NULL;
+
+    rule = __atomic_load_n(&gauleg_cache[n], __ATOMIC_ACQUIRE);
+    if (rule) return rule;
+
+    new_rule = (double*)malloc(2*n*sizeof(double));
+    if (!new_rule) return NULL;
+    gauleg_compute(new_rule, new_rule+n, n);
+
+    rule = NULL;
+    if (!__atomic_compare_exchange_n(&gauleg_cache[n], &rule, new_rule, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // other thread has been faster
+        free(new_rule);
+        return rule;
+    }
+    return new_rule;
+}
+#endif
+
+
+
 DEVICEFUNC 
 void gauleg(double x1, double x2, double x[], double w[], int n)
 //! Gauss-Legendre quadrature.
@@ -175,6 +567,8 @@ void gauleg(double x1, double x2, double x[], double w[], int n)
 //! Using n points, the method exactly integrates polynomials up to (2*n-1)'th degree.
 //! If the function \f$f(x)\f$ is well approximated by a polynomial, the integral
 //! will be very accurate.
+//! On host, the rule is taken from the cache of gauleg_rule() and only scaled to the interval
+//! (in CUDA device code it is computed on each call).
 //!
 //! @param x1 interval of integration lower limit
 //! @param x2 interval of integration upper limit
@@ -184,33 +578,105 @@ void gauleg(double x1, double x2, double x[], double w[], int n)
 //!
 //! @result Abscissas and weights are returned in x[] and w[] arrays.
 {
-    const double EPS = 3.0e-11;
-	int m,j,i;
-	double z1,z,xm,xl,pp,p3,p2,p1;
+    double xm = 0.5*(x2+x1);
+    double xl = 0.5*(x2-x1);
+    int i;
 
-	m=(n+1)/2;
-	xm=0.5*(x2+x1);
-	xl=0.5*(x2-x1);
-	for (i=1;i<=m;i++) {
-		z=cos(3.141592654*(i-0.25)/(n+0.5));
-		do {
-			p1=1.0;
-			p2=0.0;
-			for (j=1;j<=n;j++) {
-				p3=p2;
-				p2=p1;
-				p1=((2.0*j-1.0)*z*p2-(j-1.0)*p3)/j;
-			}
-			pp=n*(z*p1-p2)/(z*z-1.0);
-			z1=z;
-			z=z1-p1/pp;
-		} while (fabs(z-z1) > EPS);
-		x[i-1]=xm-xl*z;
-		x[n+1-i-1]=xm+xl*z;
-		w[i-1]=2.0*xl/((1.0-z*z)*pp*pp);
-		w[n+1-i-1]=w[i-1];
-	}
+    #ifndef CUDA
+    const double* rule = gauleg_rule(n);
+    if (rule) {
+        for (i=0; i<n; i++) {
+            x[i] = xm + xl*rule[i];
+            w[i] = xl*rule[n+i];
+        }
+    } else
+    #endif
+    {
+        gauleg_compute(x, w, n);
+        for (i=0; i<n; i++) {
+            x[i] = xm + xl*x[i];
+            w[i] = xl*w[i];
+        }
+    }
+}
+
+
+
+#ifndef CUDA
+DEVICEFUNC 
+double quad_fixed(double (*f)(double, void*), void* ctx, double a, double b, int order)
+//! Fixed-order Gauss-Legendre integral of a function.
+//! Returns the integral of the function over the interval [a,b] computed by the
+//! Gauss-Legendre rule with `order` points (see gauleg_rule()). It is a double precision 
+//! replacement of qgaus() with an arbitrary order.
+//!
+//! @param f pointer fo a function that is to be integrated
+//! @param ctx pointer that is passed to the function as its second argument
+//! @param a interval of integration lower limit
+//! @param b interval of integration upper limit
+//! @param order number of quadrature points
+//!
+//! @result Value of the integral over the interval [a,b].
+{
+    struct integrate_scalar w = {f, ctx};
+    double result;
+    quad_fixed_batch(integrate_scalar_call, &w, &a, &b, 1, order, &result);
+    return result;
+}
+
+
+
+DEVICEFUNC 
+void quad_fixed_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, const double a[], const double b[], long m, int order, double result[])
+//! Fixed-order Gauss-Legendre integrals over many intervals.
+//! Computes integrals of a batch function over `m` intervals [a[i],b[i]] (e.g. radial annuli
+//! or spectral bins) using one Gauss-Legendre rule with `order` points. The quadrature nodes 
+//! of consecutive intervals are passed to the integrand together (in batches of at most 256 
+//! points), which allows the integrand to vectorize its evaluation.
+//!
+//! @param f pointer fo a function that is to be integrated; it evaluates abscissae `x[0..n-1]` 
+//!        and stores the values to `y[0..n-1]`
+//! @param ctx pointer that is passed to the function as its last argument
+//! @param a array of lower limits of the intervals
+//! @param b array of upper limits of the intervals
+//! @param m number of intervals
+//! @param order number of quadrature points
+//! @param result output array of integrals over the intervals
+{
+    double x[INTEGRATE_CHUNK], y[INTEGRATE_CHUNK];
+    double* tmp = NULL;
+    const double* rule = gauleg_rule(order);
+    long total = m*order;
+    long t, i, n, k, j;
+
+    if (!rule) {
+        // orders out of cache range are computed for this call
+        tmp = (double*)malloc(2*order*sizeof(double));
+        gauleg_compute(tmp, tmp+order, order);
+        rule = tmp;
+    }
+
+    for (i=0; i<m; i++) result[i] = 0.0;
+
+    // go through all nodes of all intervals (node t is node j=t%order of interval k=t/order)
+    for (t=0; t<total; t+=n) {
+        long k0 = t/order;
+        long j0 = t%order;
+        n = (total-t < INTEGRATE_CHUNK) ? total-t : INTEGRATE_CHUNK;
+        for (i=0, k=k0, j=j0; i<n; i++) {
+            x[i] = 0.5*(a[k]+b[k]) + 0.5*(b[k]-a[k])*rule[j];
+            if (++j == order) { j = 0; k++; }
+        }
+        f(x, y, n, ctx);
+        for (i=0, k=k0, j=j0; i<n; i++) {
+            result[k] += 0.5*(b[k]-a[k])*rule[order+j]*y[i];
+            if (++j == order) { j = 0; k++; }
+        }
+    }
+
+    free(tmp);
 }
+#endif
 
 
 
@@ -265,4 +731,7 @@ double qgaus_general(double w[], double y[], int N, double a, double b)
 
 #undef NMAX_TRAPEZOID
 #undef NMAX_SIMPSON
+#undef NMAX_GK15
+#undef INTEGRATE_CHUNK
+#undef GAULEG_MAX_ORDER
 
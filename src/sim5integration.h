@@ -19,9 +19,23 @@ extern "C" {
 #endif
 
 DEVICEFUNC double integrate_trapezoid(double(*f)(double), double a, double b, double acc);
+DEVICEFUNC double integrate_trapezoid_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc);
+DEVICEFUNC double integrate_trapezoid_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc);
 DEVICEFUNC double integrate_simpson(double (*f)(double), double a, double b, double acc);
+DEVICEFUNC double integrate_simpson_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc);
+DEVICEFUNC double integrate_simpson_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc);
+#ifndef CUDA
+DEVICEFUNC double integrate_gk15(double (*f)(double), double a, double b, double acc);
+DEVICEFUNC double integrate_gk15_ctx(double (*f)(double, void*), void* ctx, double a, double b, double acc);
+DEVICEFUNC double integrate_gk15_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, double a, double b, double acc);
+#endif
 
 DEVICEFUNC void gauleg(double x1, double x2, double x[], double w[], int n);
+#ifndef CUDA
+DEVICEFUNC const double* gauleg_rule(int n);
+DEVICEFUNC double quad_fixed(double (*f)(double, void*), void* ctx, double a, double b, int order);
+DEVICEFUNC void quad_fixed_batch(void (*f)(const double x[], double y[], long n, void* ctx), void* ctx, const double a[], const double b[], long m, int order, double result[]);
+#endif
 
 #ifdef __cplusplus
 }
@@ -35,6 +35,7 @@ long sim5_interp_search(const double x_array[], double x, long index_lo, long in
 {
     long ilo = index_lo;
     long ihi = index_hi;
+    SIM5_COUNT(SIM5_STAT_INTERP_SEARCH);
     while(ihi > ilo + 1) {
         long i = (ihi + ilo)/2;
         if (x < x_array[i])
@@ -51,26 +52,148 @@ long sim5_interp_search(const double x_array[], double x, long index_lo, long in
 
 //! \cond SKIP
 DEVICEFUNC INLINE
-long sim5_interp_search_accel(sim5interp* interp, double x)
+long sim5_interp_search_accel(sim5interp* interp, sim5interp_accel* acc, double x)
 // performs an accelerated search of an array of values having cached the last used index
+// (the cache is owned by the caller, so that the interpolation object itself is not modified)
 {
-    long x_index = interp->last_index;
+    long x_index = acc->last_index;
+    if ((x_index < 0) || (x_index > interp->N-2)) x_index = (interp->N-1)/2;
     if(x < interp->X[x_index]) {
-        //interp->miss_count++;
-        interp->last_index = sim5_interp_search(interp->X, x, 0, x_index);
+        x_index = sim5_interp_search(interp->X, x, 0, x_index);
     } else
     if(x >= interp->X[x_index + 1]) {
-        //interp->miss_count++;
-        interp->last_index = sim5_interp_search(interp->X, x, x_index, interp->N-1);
-    } //else {
-        //interp->hit_count++;
-    //}
-    return interp->last_index;
+        x_index = sim5_interp_search(interp->X, x, x_index, interp->N-1);
+    }
+    acc->last_index = x_index;
+    return x_index;
 }
 //! \endcond
 
 
 
+//! \cond SKIP
+// maximal deviation of a grid node from its position on the uniform grid (in units of the grid step),
+// for which the directly calculated index is at most one interval off and it can be fixed by one comparison
+#define INTERP_GRID_TOL 0.1
+
+
+DEVICEFUNC INLINE static
+int sim5_interp_grid_fits(sim5interp* interp, long i)
+// checks if i-th node lies on the uniform grid given by grid_x0 and grid_dx_1
+{
+    double t = (interp->grid == INTERP_GRID_LOGUNIFORM) ? log(interp->X[i]) : interp->X[i];
+    return (fabs((t - interp->grid_x0)*interp->grid_dx_1 - (double)(i)) <= INTERP_GRID_TOL);
+}
+
+
+DEVICEFUNC static
+void sim5_interp_grid_detect(sim5interp* interp)
+// detects if X grid is (nearly) uniform in X or in log(X)
+{
+    long i, N = interp->N;
+
+    interp->grid = INTERP_GRID_IRREGULAR;
+    if (N < 2) return;
+
+    interp->grid = INTERP_GRID_UNIFORM;
+    interp->grid_x0   = interp->X[0];
+    interp->grid_dx_1 = (double)(N-1)/(interp->X[N-1]-interp->X[0]);
+    for (i=1; i<N-1; i++) if (!sim5_interp_grid_fits(interp, i)) break;
+    if (i >= N-1) return;
+
+    interp->grid = INTERP_GRID_IRREGULAR;
+    if (interp->X[0] <= 0.0) return;
+
+    interp->grid = INTERP_GRID_LOGUNIFORM;
+    interp->grid_x0   = log(interp->X[0]);
+    interp->grid_dx_1 = (double)(N-1)/(log(interp->X[N-1])-interp->grid_x0);
+    for (i=1; i<N-1; i++) if (!sim5_interp_grid_fits(interp, i)) break;
+    if (i >= N-1) return;
+
+    interp->grid = INTERP_GRID_IRREGULAR;
+}
+
+
+DEVICEFUNC static
+void sim5_interp_grid_push(sim5interp* interp)
+// updates the grid spacing after the last node has been pushed in (INTERP_DATA_BUILD model);
+// the step of a uniform grid is taken from the first two nodes, so that the check is O(1) per node
+{
+    long i = interp->N-1;
+
+    if (i < 1) {
+        interp->grid = INTERP_GRID_IRREGULAR;
+        return;
+    }
+
+    if (i == 1) {
+        interp->grid = INTERP_GRID_UNIFORM;
+        interp->grid_x0   = interp->X[0];
+        interp->grid_dx_1 = 1.0/(interp->X[1]-interp->X[0]);
+        return;
+    }
+
+    if ((interp->grid == INTERP_GRID_IRREGULAR) || (sim5_interp_grid_fits(interp, i))) return;
+
+    // the node does not fit a grid uniform in X, try a grid uniform in log(X)
+    // (all nodes are checked, but this happens at most once)
+    if ((interp->grid == INTERP_GRID_UNIFORM) && (interp->X[0] > 0.0)) {
+        long k;
+        interp->grid = INTERP_GRID_LOGUNIFORM;
+        interp->grid_x0   = log(interp->X[0]);
+        interp->grid_dx_1 = 1.0/(log(interp->X[1])-interp->grid_x0);
+        for (k=2; k<=i; k++) if (!sim5_interp_grid_fits(interp, k)) break;
+        if (k > i) return;
+    }
+
+    interp->grid = INTERP_GRID_IRREGULAR;
+}
+
+
+DEVICEFUNC INLINE static
+long sim5_interp_index(sim5interp* interp, sim5interp_accel* acc, double x, double lnx)
+// finds the index of the grid interval for x (lnx=log(x) is only used on log-uniform grids,
+// acc is only used on irregular grids and may be NULL); the result is the same as of sim5_interp_search()
+{
+    long i, N = interp->N;
+    double t;
+
+    switch (interp->grid) {
+        case INTERP_GRID_UNIFORM:    t = (x - interp->grid_x0)*interp->grid_dx_1; break;
+        case INTERP_GRID_LOGUNIFORM: t = (lnx - interp->grid_x0)*interp->grid_dx_1; break;
+        default:
+            if (acc)
+                return sim5_interp_search_accel(interp, acc, x);
+            else
+                return sim5_interp_search(interp->X, x, 0, N-1);
+    }
+
+    SIM5_COUNT(SIM5_STAT_INTERP_DIRECT);
+
+    if (!(t > 0.0)) i = 0; else
+    if (t >= (double)(N-2)) i = N-2; else
+    i = (long)t;
+
+    if ((i > 0) && (x < interp->X[i])) i--; else
+    if ((i < N-2) && (x >= interp->X[i+1])) i++;
+    return i;
+}
+
+
+DEVICEFUNC static
+void sim5_interp_prelog(sim5interp* interp, long i0, long i1)
+// fills pre-logged arrays for nodes i0..i1-1
+{
+    long i;
+    if (interp->lnX) for (i=i0; i<i1; i++) interp->lnX[i] = log(interp->X[i]);
+    if (interp->lnY) for (i=i0; i<i1; i++) interp->lnY[i] = log(interp->Y[i]);
+}
+
+#undef INTERP_GRID_TOL
+//! \endcond
+
+
+
 //! \cond SKIP
 DEVICEFUNC
 static void spline(double x[], double y[], int n, double yp1, double ypn, double y2[])
@@ -87,15 +210,15 @@ static void spline(double x[], double y[], int n, double yp1, double ypn, double
 {
     int i,k;
     double p, qn, sig, un, *u;
+    sim5arena* arena = sim5_arena_current();
 
     //MALLOC(u,float,n-1);
-    u = (double*)malloc((n-1)*sizeof(double));
-    //#ifndef CUDA
-    if (u == NULL) exit(EXIT_FAILURE);
-    //#else
-    //asm("exit;");    
-    //#endif
-    //fprintf(stderr,"ERR %s line %d: Memory allocation failure.\n",  __FILE__, __LINE__);
+    u = (double*)sim5_arena_malloc(arena, (n-1)*sizeof(double));
+    if (u == NULL) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "spline", "memory allocation failure");
+        for (i = 0; i < n; i++) y2[i] = 0.0;
+        return;
+    }
 
     if(yp1 > 0.99e30)
         y2[0] = u[0] = 0.0;
@@ -125,46 +248,25 @@ static void spline(double x[], double y[], int n, double yp1, double ypn, double
         y2[k] = y2[k]*y2[k+1] + u[k];
     }
 
-    free(u);
+    sim5_arena_free(arena, u);
 }
 //! \endcond
 
 
 
 //! \cond SKIP
-DEVICEFUNC
-static double splint(double xa[], double ya[], double y2a[], int n, double x)
+DEVICEFUNC INLINE
+static double splint(double xa[], double ya[], double y2a[], long klo, double x)
 //! Cubic spline interpolation.
 //! - given the arrays xa[] and ya[] of dimension N, which tabulate a function and
 //!   given the array y2a[] , which is the output from spline() routine,
 //!   this routine returns a cubic-spline interpolated value y at point x
+//!   that lies in the interval [xa[klo], xa[klo+1]] (the interval is found by the caller)
 //! - xa[] must be orderd array
 //! (routine from Numerical Recipes in C)
 {
-    int  klo,khi,k;
+    long khi = klo+1;
     double h,b,a;
-    static int pklo=0, pkhi=1;
-
-    #pragma omp threadprivate(pklo,pkhi)
-
-    // Assuming that calls to this function are made with closely-spaced,
-    // steadily-increasing values of x, we first try using the same values of klo and khi
-    // as were used in the previous invocation.
-    // If that interval is no longer correct, a standard binary search looks for the correct interval.
-    if(xa[pklo] <= x && xa[pkhi] > x){
-        klo = pklo;
-        khi = pkhi;
-    }
-    else{
-        klo = 0;
-        khi = n-1;
-        while (khi-klo > 1){
-            k = (khi + klo) >> 1;
-            if(xa[k] > x) khi = k; else klo = k;
-        }
-        pklo = klo;
-        pkhi = khi;
-    }
 
     h = xa[khi] - xa[klo];
     // we can skip this check since have checked that already during sim5interp initialization
@@ -176,6 +278,117 @@ static double splint(double xa[], double ya[], double y2a[], int n, double x)
     b = (x - xa[klo])/h;
     return  a*ya[klo] + b*ya[khi] + ((a*a*a - a)*y2a[klo] + (b*b*b - b)*y2a[khi])*(h*h)/6.0;
 }
+
+
+DEVICEFUNC static
+void steffen(double x[], double y[], long n, double c[])
+// Calculates coefficients of monotone piecewise cubic interpolation (Steffen 1990, A&A 239, 443).
+// - the derivative at each point is limited so that the interpolating function is monotone
+//   between the points and it has no extrema other than at the points
+// - coefficients for interval [x[i],x[i+1]] are stored in c[4*i..4*i+3], such that the
+//   interpolated value is c0 + c1*t + c2*t^2 + c3*t^3 with t=x-x[i]
+{
+    long i;
+    double h0, h1, s0, s1, p, d0, d1;
+
+    if (n < 2) return;
+    if (n == 2) {
+        s0 = (y[1]-y[0])/(x[1]-x[0]);
+        c[0] = y[0]; c[1] = s0; c[2] = 0.0; c[3] = 0.0;
+        return;
+    }
+
+    // derivative at the first point
+    h0 = x[1]-x[0];  s0 = (y[1]-y[0])/h0;
+    h1 = x[2]-x[1];  s1 = (y[2]-y[1])/h1;
+    p  = s0*(1.0 + h0/(h0+h1)) - s1*h0/(h0+h1);
+    d0 = (p*s0 <= 0.0) ? 0.0 : ((fabs(p) > 2.0*fabs(s0)) ? 2.0*s0 : p);
+
+    for (i=0; i<n-1; i++) {
+        h0 = x[i+1]-x[i];
+        s0 = (y[i+1]-y[i])/h0;
+
+        // derivative at the point i+1
+        if (i < n-2) {
+            h1 = x[i+2]-x[i+1];
+            s1 = (y[i+2]-y[i+1])/h1;
+            p  = (s0*h1 + s1*h0)/(h0+h1);
+            d1 = (copysign(1.0,s0) + copysign(1.0,s1)) * fmin(fmin(fabs(s0), fabs(s1)), 0.5*fabs(p));
+        } else {
+            // last point
+            h1 = x[i]-x[i-1];
+            s1 = (y[i]-y[i-1])/h1;
+            p  = s0*(1.0 + h0/(h0+h1)) - s1*h0/(h0+h1);
+            d1 = (p*s0 <= 0.0) ? 0.0 : ((fabs(p) > 2.0*fabs(s0)) ? 2.0*s0 : p);
+        }
+
+        c[4*i+0] = y[i];
+        c[4*i+1] = d0;
+        c[4*i+2] = (3.0*s0 - 2.0*d0 - d1)/h0;
+        c[4*i+3] = (d0 + d1 - 2.0*s0)/(h0*h0);
+        d0 = d1;
+    }
+}
+
+
+DEVICEFUNC static
+double* sim5_interp_make_coeffs(sim5interp* interp, sim5arena* arena)
+// allocates (from arena or by malloc if arena is NULL) and calculates coefficients for cubic interpolation types
+{
+    double* c = NULL;
+    if (interp->type == INTERP_TYPE_SPLINE) {
+        c = (double*)sim5_arena_malloc(arena, interp->N*sizeof(double));
+        if (c) spline(interp->X, interp->Y, interp->N, 1e50, 1e50, c);
+    } else
+    if (interp->type == INTERP_TYPE_STEFFEN) {
+        c = (double*)sim5_arena_malloc(arena, 4*(interp->N-1)*sizeof(double));
+        if (c) steffen(interp->X, interp->Y, interp->N, c);
+    }
+    if (!c) SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_interp_make_coeffs", "memory allocation failure (interpolation coefficients)");
+    return c;
+}
+
+
+DEVICEFUNC static
+double* sim5_interp_coeffs(sim5interp* interp)
+// returns coefficients for cubic interpolation types (second derivatives for spline interpolation, 
+// per-interval polynomial coefficients for monotone interpolation); they are calculated in sim5_interp_init(),
+// only for INTERP_DATA_BUILD model they are made on the first evaluation after the data have been pushed in,
+// in which case the array is published atomically, so that concurrent evaluations are safe
+// (such arrays are always allocated by malloc, as the evaluating thread may not own the object's arena)
+{
+    double** field = (interp->type == INTERP_TYPE_SPLINE) ? &interp->d2Y : &interp->coef;
+    double* c = __atomic_load_n(field, __ATOMIC_ACQUIRE);
+    if (c) return c;
+
+    double* new_c = sim5_interp_make_coeffs(interp, NULL);
+    if (!new_c) return NULL;
+
+    c = NULL;
+    if (!__atomic_compare_exchange_n(field, &c, new_c, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // other thread has been faster
+        free(new_c);
+        return c;
+    }
+    return new_c;
+}
+//! \endcond
+
+
+
+//! \cond SKIP
+DEVICEFUNC static
+void sim5_interp_empty(sim5interp* interp)
+// makes an empty object (after a failed initialization), which can be safely finalized
+{
+    interp->datamodel = INTERP_DATA_REF;
+    interp->N    = 0;
+    interp->capa = 0;
+    interp->X    = NULL;
+    interp->Y    = NULL;
+    interp->xmin = 0.0;
+    interp->xmax = 0.0;
+}
 //! \endcond
 
 
@@ -201,44 +414,46 @@ void sim5_interp_init(sim5interp* interp, double xa[], double ya[], long N, int
 //!        INTERP_TYPE_LINLOG=linear interpolation in X, logarithmic in Y,
 //!        INTERP_TYPE_LOGLIN=logarithmic interpolation in X, linear in Y,
 //!        INTERP_TYPE_LOGLOG=logarithmic interpolation in both X and Y,
-//!        INTERP_TYPE_SPLINE=linear cubic spline interpolation 
+//!        INTERP_TYPE_SPLINE=linear cubic spline interpolation,
+//!        INTERP_TYPE_STEFFEN=monotone piecewise cubic interpolation (it does not overshoot the data, can extrapolate)
 //! @param interp_options specifies additional options (a combination of options can be used):
-//!        INTERP_OPT_ACCEL=interpolation will use acceleration (cashing of index values),
+//!        INTERP_OPT_ACCEL=kept for compatibility, it has no effect (index caching is done by sim5_interp_eval_accel()),
 //!        INTERP_OPT_CAN_EXTRAPOLATE=extrapolation is allowed when an `x` value for an of-out-grid point is requested
 //!
+//! The routine detects grids that are uniform in X or in log(X); on such grids the interval
+//! is found directly instead of by bisection. For logarithmic interpolation types, logarithms of X and/or Y
+//! values are stored with the object, so with INTERP_DATA_REF the referenced arrays must not change after initialization.
+//! Coefficients of spline interpolation are calculated here as well (with INTERP_DATA_BUILD on the first evaluation),
+//! so the initialized object is read-only during evaluation and it can be shared between threads.
+//! On invalid input (e.g. unordered grid) the error is reported (see sim5_error_last()) and the object
+//! is left empty; its evaluation then gives NAN.
+//!
 //! @result Returns `interp` object to be used in actual interpolation.
 {
-    if ((interp_type==INTERP_TYPE_SPLINE) && (interp_options & INTERP_OPT_CAN_EXTRAPOLATE)) {
-        //#ifndef CUDA
-        fprintf(stderr, "ERR (sim5_interp_init): spline interpolation cannot be used with extrapolation option\n");
-        //#endif
-        return;
-    }
-
-
     interp->datamodel = data_model;
     interp->type      = interp_type;
     interp->options   = interp_options;
     interp->d2Y       = NULL;
+    interp->coef      = NULL;
+    interp->lnX       = NULL;
+    interp->lnY       = NULL;
+    interp->grid      = INTERP_GRID_IRREGULAR;
+    interp->arena     = sim5_arena_current();
+
+    if ((interp_type==INTERP_TYPE_SPLINE) && (interp_options & INTERP_OPT_CAN_EXTRAPOLATE)) {
+        SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interp_init", "spline interpolation cannot be used with extrapolation option");
+        sim5_interp_empty(interp);
+        return;
+    }
 
     // check of order
     if ((interp->datamodel==INTERP_DATA_REF) || (interp->datamodel==INTERP_DATA_COPY)) {
         long i;
         for (i=0; i<N-1; i++) {
             if (xa[i] >= xa[i+1]) {
-                //#ifndef CUDA
-                fprintf(stderr, "ERR (sim5_interp_init): unordered X grid (x[%ld]=%.4e, x[%ld]=%.4e, N=%ld, opt=%d)\n", i, xa[i], i+1, xa[i+1], N, interp_options);
-                backtrace();
-                //#endif
-                
-                interp->N = 0;
-                interp->X = NULL;
-                interp->Y = NULL;
-                //#ifndef CUDA
-                exit(-1);//return;
-                //#else
-                //asm("exit;");
-                //#endif
+                SIM5_ERROR(SIM5_ERR_GRID, "sim5_interp_init", "unordered X grid (x[%ld]=%.4e, x[%ld]=%.4e, N=%ld, opt=%d)", i, xa[i], i+1, xa[i+1], N, interp_options);
+                sim5_interp_empty(interp);
+                return;
             }
         }
     }
@@ -252,42 +467,69 @@ void sim5_interp_init(sim5interp* interp, double xa[], double ya[], long N, int
             interp->Y = ya;
             interp->xmin = interp->X[0];
             interp->xmax = interp->X[N-1];
-            interp->last_index = (N-1)/2;
             break;
 
         case INTERP_DATA_COPY:
             // make copy of arrays
             interp->N = N;
             interp->capa = N;
-            interp->X = (double*)malloc(N*sizeof(double));
-            interp->Y = (double*)malloc(N*sizeof(double));
+            interp->X = (double*)sim5_arena_malloc(interp->arena, N*sizeof(double));
+            interp->Y = (double*)sim5_arena_malloc(interp->arena, N*sizeof(double));
+            if ((!interp->X) || (!interp->Y)) break;
             memcpy (interp->X, xa, N*sizeof(double));
             memcpy (interp->Y, ya, N*sizeof(double));
             interp->xmin = interp->X[0];
             interp->xmax = interp->X[N-1];
-            interp->last_index = (N-1)/2;
             break;
 
         case INTERP_DATA_BUILD:
             // make copy of arrays
             interp->N = 0;
             interp->capa = N>0 ? N : 100;
-            interp->X = (double*)calloc(interp->capa, sizeof(double));
-            interp->Y = (double*)calloc(interp->capa, sizeof(double));
+            interp->X = (double*)sim5_arena_malloc(interp->arena, interp->capa*sizeof(double));
+            interp->Y = (double*)sim5_arena_malloc(interp->arena, interp->capa*sizeof(double));
             interp->xmin = 0.0;
             interp->xmax = 0.0;
-            interp->last_index = 0;
             break;
 
         default:
-            //#ifndef CUDA
-            fprintf(stderr, "ERR (sim5_interp_init): unimplemented data model (%d)\n", interp->datamodel);
-            exit(-1);//return;
-            //#else
-            //asm("exit;");
-            //#endif
+            SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interp_init", "unimplemented data model (%d)", interp->datamodel);
+            sim5_interp_empty(interp);
+            return;
     }
 
+    // pre-logged arrays for logarithmic interpolation types
+    long size = (interp->datamodel==INTERP_DATA_BUILD) ? interp->capa : interp->N;
+    int failed = (interp->datamodel != INTERP_DATA_REF) && ((!interp->X) || (!interp->Y));
+    if ((interp->type==INTERP_TYPE_LOGLIN) || (interp->type==INTERP_TYPE_LOGLOG)) {
+        interp->lnX = (double*)sim5_arena_malloc(interp->arena, size*sizeof(double));
+        failed |= (!interp->lnX);
+    }
+    if ((interp->type==INTERP_TYPE_LINLOG) || (interp->type==INTERP_TYPE_LOGLOG)) {
+        interp->lnY = (double*)sim5_arena_malloc(interp->arena, size*sizeof(double));
+        failed |= (!interp->lnY);
+    }
+    if (failed) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_interp_init", "memory allocation failure (N=%ld)", N);
+        sim5_interp_done(interp);
+        sim5_interp_empty(interp);
+        return;
+    }
+    sim5_interp_prelog(interp, 0, interp->N);
+
+    sim5_interp_grid_detect(interp);
+
+    // coefficients of cubic types are made here, so that evaluation does not modify the object
+    if (interp->N > 1) {
+        if (interp->type==INTERP_TYPE_SPLINE)  interp->d2Y  = sim5_interp_make_coeffs(interp, interp->arena);
+        if (interp->type==INTERP_TYPE_STEFFEN) interp->coef = sim5_interp_make_coeffs(interp, interp->arena);
+        if ((interp->type==INTERP_TYPE_SPLINE) || (interp->type==INTERP_TYPE_STEFFEN)) {
+            if ((!interp->d2Y) && (!interp->coef)) {
+                sim5_interp_done(interp);
+                sim5_interp_empty(interp);
+            }
+        }
+    }
 }
 
 
@@ -304,36 +546,51 @@ void sim5_interp_data_push(sim5interp* interp, double x, double y)
 //! @param y y-value of data point
 {
     if (interp->datamodel != INTERP_DATA_BUILD) {
-        //#ifndef CUDA
-        fprintf(stderr, "ERR (sim5_interp_data_push): you can only push in data with INTERP_DATA_BUILD data model\n");
-        //#endif
+        SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interp_data_push", "you can only push in data with INTERP_DATA_BUILD data model");
         return;
     }
 
     long i = interp->N;
 
     if ((i>0) && (interp->X[i-1] >= x)) {
-        //#ifndef CUDA
-        fprintf(stderr, "ERR (sim5_interp_data_push): unordered X grid (x[%ld]=%.4e, x[%ld]=%.4e)\n", i-1, interp->X[i-1], i, x);
-        exit(-1);//return;
-        //#else
-        //asm("exit;");
-        //#endif
+        SIM5_ERROR(SIM5_ERR_GRID, "sim5_interp_data_push", "unordered X grid (x[%ld]=%.4e, x[%ld]=%.4e), point is ignored", i-1, interp->X[i-1], i, x);
+        return;
+    }
+
+    if (interp->N >= interp->capa) {
+        // grow arrays (an array that has been moved is kept even if a later one fails)
+        long capa = (interp->capa > 0) ? 2*interp->capa : 100;
+        double* p;
+        int failed = 0;
+        if ((p = (double*)sim5_arena_realloc(interp->arena, interp->X, capa*sizeof(double)))) interp->X = p; else failed = 1;
+        if ((p = (double*)sim5_arena_realloc(interp->arena, interp->Y, capa*sizeof(double)))) interp->Y = p; else failed = 1;
+        if (interp->lnX) { if ((p = (double*)sim5_arena_realloc(interp->arena, interp->lnX, capa*sizeof(double)))) interp->lnX = p; else failed = 1; }
+        if (interp->lnY) { if ((p = (double*)sim5_arena_realloc(interp->arena, interp->lnY, capa*sizeof(double)))) interp->lnY = p; else failed = 1; }
+        if (failed) {
+            SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_interp_data_push", "memory allocation failure (N=%ld), point is ignored", i);
+            return;
+        }
+        interp->capa = capa;
     }
 
     interp->X[i] = x;
     interp->Y[i] = y;
     interp->N++;
-
-    if (interp->N >= interp->capa) {
-        interp->capa *= 2;
-        interp->X = (double*)realloc(interp->X, interp->capa*sizeof(double));
-        interp->Y = (double*)realloc(interp->Y, interp->capa*sizeof(double));
-    }
+    sim5_interp_prelog(interp, i, i+1);
 
     interp->xmin = interp->X[0];
     interp->xmax = interp->X[i];
-    interp->last_index = i/2;
+    sim5_interp_grid_push(interp);
+
+    // coefficients of cubic types have to be remade
+    if (interp->d2Y) {
+        free(interp->d2Y);
+        interp->d2Y = NULL;
+    }
+    if (interp->coef) {
+        free(interp->coef);
+        interp->coef = NULL;
+    }
 }
 
 
@@ -342,74 +599,283 @@ DEVICEFUNC
 double sim5_interp_eval(sim5interp* interp, double x)
 //! Interpolated data evaluation.
 //! Makes the evalutaion on interpolated grid at given point.
+//! The interpolation object is not modified, so the same object can be evaluated by several threads at once.
 //!
 //! @param interp interpolation object
 //! @param x value for which to get interpolated value
 //!
 //! @result Interpolated value.
 {
-    double x_lo, x_hi;
-    double y_lo, y_hi;
-    long index;
+    return sim5_interp_eval_accel(interp, NULL, x);
+}
 
-    // treat spline interpolation seperately
-    if (interp->type == INTERP_TYPE_SPLINE) {
-        // calculate second derivatives if they are not yet available
-        if (!interp->d2Y) {
-            interp->d2Y = (double*) malloc(interp->N*sizeof(double));
-            spline(interp->X, interp->Y, interp->N, 1e50, 1e50, interp->d2Y);
-        }
-        return splint(interp->X, interp->Y, interp->d2Y, interp->N, x);
-    }
+
+
+DEVICEFUNC
+void sim5_interp_accel_reset(sim5interp_accel* acc)
+//! Interpolation accelerator reset.
+//! Initializes (or resets) the accelerator object for use with sim5_interp_eval_accel().
+//! A zero-initialized accelerator object can be used as well.
+//!
+//! @param acc accelerator object
+{
+    acc->last_index = 0;
+}
 
 
 
-    if ((!(interp->options & INTERP_OPT_CAN_EXTRAPOLATE)) && ((x < interp->xmin) || (x > interp->xmax))) {
-        //#ifndef CUDA
-        fprintf(stderr, "WRN (sim5_interp_eval): unwarranted extrapolation (x=%.4e, xmin=%.4e, xmax=%.4e)\n", x, interp->xmin, interp->xmax);
-        //#endif
+DEVICEFUNC
+double sim5_interp_eval_accel(sim5interp* interp, sim5interp_accel* acc, double x)
+//! Interpolated data evaluation with acceleration.
+//! Makes the evalutaion on interpolated grid at given point. On irregular grids, the index of the grid interval
+//! found in the last call is kept in the accelerator object `acc` and it is tried first, which speeds up
+//! evaluation for sequences of close `x` values. The accelerator is owned by the caller (e.g. one per thread),
+//! while the interpolation object is only read and can be shared. On uniform grids the accelerator is not needed.
+//!
+//! @param interp interpolation object
+//! @param acc accelerator object (may be NULL, in which case bisection search is used)
+//! @param x value for which to get interpolated value
+//!
+//! @result Interpolated value.
+{
+    double lnx = 0.0;
+    long i;
+
+    if (interp->N < 2) {
+        SIM5_ERROR(SIM5_ERR_GRID, "sim5_interp_eval", "too few data points (N=%ld)", interp->N);
+        return NAN;
     }
 
-    if (interp->options & INTERP_OPT_ACCEL) {
-        // index search with acceleration
-        index = sim5_interp_search_accel(interp, x);
-    } else {
-        // index search without acceleration
-        index = sim5_interp_search(interp->X, x, 0, interp->N-1);
+    // logarithm of x is needed for logarithmic types and for the index on log-uniform grids
+    if ((interp->lnX) || (interp->grid == INTERP_GRID_LOGUNIFORM)) lnx = log(x);
+
+    // treat spline interpolation seperately
+    if (interp->type == INTERP_TYPE_SPLINE) {
+        double* d2Y = sim5_interp_coeffs(interp);
+        if (!d2Y) return NAN;
+        i = sim5_interp_index(interp, acc, x, lnx);
+        return splint(interp->X, interp->Y, d2Y, i, x);
     }
 
-    x_lo = interp->X[index];
-    x_hi = interp->X[index + 1];
-    y_lo = interp->Y[index];
-    y_hi = interp->Y[index + 1];
+    if ((!(interp->options & INTERP_OPT_CAN_EXTRAPOLATE)) && ((x < interp->xmin) || (x > interp->xmax))) {
+        SIM5_ERROR(SIM5_WRN_EXTRAPOLATION, "sim5_interp_eval", "unwarranted extrapolation (x=%.4e, xmin=%.4e, xmax=%.4e)", x, interp->xmin, interp->xmax);
+    }
 
-    // seems unnecessary as we have checked on order of X array already on initialization
-    //if (x_lo >= x_hi) {
-    //    fprintf(stderr, "ERR (sim5_interp_eval: unordered X grid (x[%ld]=%.4e, x[%ld]=%.4e, N=%ld)\n", index, x_lo, index+1, x_hi, interp->N);
-    //    return NAN;
-    //}
+    i = sim5_interp_index(interp, acc, x, lnx);
 
+    // logarithms of grid values are precomputed, so that at most one exp() is needed
     switch (interp->type) {
+        case INTERP_TYPE_STEFFEN: {
+            const double* c = sim5_interp_coeffs(interp);
+            double t = x - interp->X[i];
+            if (!c) return NAN;
+            // linear extrapolation with the slope at the boundary
+            if (x < interp->xmin) return c[0] + c[1]*t;
+            if (x > interp->xmax) {
+                double h = interp->X[i+1] - interp->X[i];
+                c += 4*i;
+                return interp->Y[i+1] + (c[1] + h*(2.0*c[2] + 3.0*h*c[3]))*(x - interp->X[i+1]);
+            }
+            c += 4*i;
+            return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+        }
+
         case INTERP_TYPE_LINLIN:
-            return y_lo + (x-x_lo)/(x_hi-x_lo) * (y_hi-y_lo);
+            return interp->Y[i] + (x-interp->X[i])/(interp->X[i+1]-interp->X[i]) * (interp->Y[i+1]-interp->Y[i]);
+
+        case INTERP_TYPE_LINLOG:
+            return exp(interp->lnY[i] + (x-interp->X[i])/(interp->X[i+1]-interp->X[i]) * (interp->lnY[i+1]-interp->lnY[i]));
 
         case INTERP_TYPE_LOGLOG:
-            return exp(log(y_lo) + (log(x)-log(x_lo)) / (log(x_hi) - log(x_lo)) * (log(y_hi)-log(y_lo)));
-            // equvivalent to: exp(log(y_lo) + (log(x)-log(x_lo)) / (log(x_hi) - log(x_lo)) * (log(y_hi)-log(y_lo)))
+            return exp(interp->lnY[i] + (lnx-interp->lnX[i])/(interp->lnX[i+1]-interp->lnX[i]) * (interp->lnY[i+1]-interp->lnY[i]));
 
         case INTERP_TYPE_LOGLIN:
-            return y_lo + log(x/x_lo)/log(x_hi/x_lo) * (y_hi-y_lo);
-            // equvivalent to: y_lo + (log(x)-log(x_lo)) / (log(x_hi) - log(x_lo)) * (y_hi - y_lo)
+            return interp->Y[i] + (lnx-interp->lnX[i])/(interp->lnX[i+1]-interp->lnX[i]) * (interp->Y[i+1]-interp->Y[i]);
 
         default:
-            //#ifndef CUDA
-            fprintf(stderr, "ERR (sim5_interp_eval): unimplemented interpolation type (%d)\n", interp->type);
-            //#endif
+            SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interp_eval", "unimplemented interpolation type (%d)", interp->type);
             return NAN;
     }
 }
 
 
+
+//! \cond SKIP
+#define INTERP_BATCH_CHUNK 256
+
+DEVICEFUNC INLINE static
+long sim5_interp_search_bf(const double X[], long N, double x)
+// branch-free bisection (the comparison compiles to a conditional move);
+// gives the same result as sim5_interp_search(X, x, 0, N-1)
+{
+    const double* base = X;
+    long n = N-1;
+    while (n > 1) {
+        long half = n/2;
+        base = (base[half] <= x) ? base+half : base;
+        n -= half;
+    }
+    return base-X;
+}
+//! \endcond
+
+
+
+DEVICEFUNC
+void sim5_interp_eval_batch(sim5interp* interp, const double x[], long n, double y[])
+//! Interpolated data evaluation for an array of points.
+//! Evaluates the interpolation at `n` points, which gives the same values as calls of sim5_interp_eval().
+//! If the points are sorted in increasing order, the grid is walked through in a single pass, so
+//! the cost is O(N+n) instead of O(n log N); unsorted points use a direct index on uniform grids and
+//! a branch-free bisection otherwise. Indices are found for a block of points first and then
+//! the interpolation formula is evaluated in a separate loop, which the compiler can vectorize.
+//! The arrays `x` and `y` may be the same array.
+//!
+//! @param interp interpolation object
+//! @param x array of values for which to get interpolated values
+//! @param n number of values
+//! @param y array of interpolated values (output)
+{
+    long idx[INTERP_BATCH_CHUNK];
+    double lnx[INTERP_BATCH_CHUNK];
+    const double* X = interp->X;
+    const double* Y = interp->Y;
+    const double* lnX = interp->lnX;
+    const double* lnY = interp->lnY;
+    const double* d2Y = NULL;
+    const double* coef = NULL;
+    long N = interp->N;
+    long i, k, k0, m;
+    int sorted = 1;
+    int need_lnx = (interp->lnX) || (interp->grid == INTERP_GRID_LOGUNIFORM);
+
+    if (n <= 0) return;
+
+    if (N < 2) {
+        SIM5_ERROR(SIM5_ERR_GRID, "sim5_interp_eval_batch", "too few data points (N=%ld)", N);
+        for (k=0; k<n; k++) y[k] = NAN;
+        return;
+    }
+
+    SIM5_TIMER_START(SIM5_TIMER_INTERP_BATCH);
+
+    if (interp->type == INTERP_TYPE_SPLINE) {
+        d2Y = sim5_interp_coeffs(interp);
+    } else
+    if (interp->type == INTERP_TYPE_STEFFEN) {
+        coef = sim5_interp_coeffs(interp);
+    }
+    if (((interp->type == INTERP_TYPE_SPLINE) && (!d2Y)) || ((interp->type == INTERP_TYPE_STEFFEN) && (!coef))) {
+        for (k=0; k<n; k++) y[k] = NAN;
+        SIM5_TIMER_STOP(SIM5_TIMER_INTERP_BATCH);
+        return;
+    }
+
+    if ((interp->type != INTERP_TYPE_SPLINE) && (!(interp->options & INTERP_OPT_CAN_EXTRAPOLATE))) {
+        long outside = 0;
+        for (k=0; k<n; k++) outside += ((x[k] < interp->xmin) || (x[k] > interp->xmax));
+        if (outside > 0) {
+            SIM5_ERROR(SIM5_WRN_EXTRAPOLATION, "sim5_interp_eval_batch", "unwarranted extrapolation (%ld points, xmin=%.4e, xmax=%.4e)", outside, interp->xmin, interp->xmax);
+        }
+    }
+
+    for (k=1; k<n; k++) if (x[k] < x[k-1]) {
+        sorted = 0;
+        break;
+    }
+
+    i = sorted ? sim5_interp_search(X, x[0], 0, N-1) : 0;
+
+    for (k0=0; k0<n; k0+=INTERP_BATCH_CHUNK) {
+        const double* xc = x+k0;
+        double* yc = y+k0;
+        m = (n-k0 < INTERP_BATCH_CHUNK) ? n-k0 : INTERP_BATCH_CHUNK;
+
+        if (need_lnx) for (k=0; k<m; k++) lnx[k] = log(xc[k]);
+
+        // interval indices
+        if (sorted) {
+            for (k=0; k<m; k++) {
+                while ((i < N-2) && (xc[k] >= X[i+1])) i++;
+                idx[k] = i;
+            }
+        } else
+        if (interp->grid != INTERP_GRID_IRREGULAR) {
+            for (k=0; k<m; k++) idx[k] = sim5_interp_index(interp, NULL, xc[k], need_lnx ? lnx[k] : 0.0);
+        } else {
+            for (k=0; k<m; k++) idx[k] = sim5_interp_search_bf(X, N, xc[k]);
+            SIM5_COUNT_N(SIM5_STAT_INTERP_SEARCH, m);
+        }
+
+        // interpolated values
+        switch (interp->type) {
+            case INTERP_TYPE_LINLIN:
+                for (k=0; k<m; k++) {
+                    long j = idx[k];
+                    yc[k] = Y[j] + (xc[k]-X[j])/(X[j+1]-X[j]) * (Y[j+1]-Y[j]);
+                }
+                break;
+
+            case INTERP_TYPE_LINLOG:
+                for (k=0; k<m; k++) {
+                    long j = idx[k];
+                    yc[k] = exp(lnY[j] + (xc[k]-X[j])/(X[j+1]-X[j]) * (lnY[j+1]-lnY[j]));
+                }
+                break;
+
+            case INTERP_TYPE_LOGLOG:
+                for (k=0; k<m; k++) {
+                    long j = idx[k];
+                    yc[k] = exp(lnY[j] + (lnx[k]-lnX[j])/(lnX[j+1]-lnX[j]) * (lnY[j+1]-lnY[j]));
+                }
+                break;
+
+            case INTERP_TYPE_LOGLIN:
+                for (k=0; k<m; k++) {
+                    long j = idx[k];
+                    yc[k] = Y[j] + (lnx[k]-lnX[j])/(lnX[j+1]-lnX[j]) * (Y[j+1]-Y[j]);
+                }
+                break;
+
+            case INTERP_TYPE_SPLINE:
+                for (k=0; k<m; k++) {
+                    long j = idx[k];
+                    double h = X[j+1] - X[j];
+                    double a = (X[j+1] - xc[k])/h;
+                    double b = (xc[k] - X[j])/h;
+                    yc[k] = a*Y[j] + b*Y[j+1] + ((a*a*a - a)*d2Y[j] + (b*b*b - b)*d2Y[j+1])*(h*h)/6.0;
+                }
+                break;
+
+            case INTERP_TYPE_STEFFEN:
+                for (k=0; k<m; k++) {
+                    const double* c = coef + 4*idx[k];
+                    double t = xc[k] - X[idx[k]];
+                    yc[k] = c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+                }
+                // points outside of the grid are extrapolated linearly (as in sim5_interp_eval)
+                for (k=0; k<m; k++) {
+                    if (xc[k] < interp->xmin) yc[k] = coef[0] + coef[1]*(xc[k] - X[0]);
+                    if (xc[k] > interp->xmax) {
+                        const double* c = coef + 4*(N-2);
+                        double h = X[N-1] - X[N-2];
+                        yc[k] = Y[N-1] + (c[1] + h*(2.0*c[2] + 3.0*h*c[3]))*(xc[k] - X[N-1]);
+                    }
+                }
+                break;
+
+            default:
+                SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interp_eval_batch", "unimplemented interpolation type (%d)", interp->type);
+                for (k=0; k<m; k++) yc[k] = NAN;
+        }
+    }
+
+    SIM5_TIMER_STOP(SIM5_TIMER_INTERP_BATCH);
+}
+
+#undef INTERP_BATCH_CHUNK
+
+
 /*
 double sim5_interp_integral(sim5interp* interp, double a, double b)
 // makes the evalutaion of interpolated grid at point x
@@ -430,13 +896,23 @@ void sim5_interp_done(sim5interp* interp)
 //!
 //! @param interp interpolation object
 {
+    // coefficients are made by malloc for INTERP_DATA_BUILD (see sim5_interp_coeffs())
+    sim5arena* coef_arena = (interp->datamodel==INTERP_DATA_BUILD) ? NULL : interp->arena;
+
+    if (interp->lnY) sim5_arena_free(interp->arena, interp->lnY);
+    if (interp->lnX) sim5_arena_free(interp->arena, interp->lnX);
+    if (interp->coef) sim5_arena_free(coef_arena, interp->coef);
+    if (interp->d2Y) sim5_arena_free(coef_arena, interp->d2Y);
+
     if ((interp->datamodel==INTERP_DATA_COPY) || (interp->datamodel==INTERP_DATA_BUILD)){
-        free(interp->X);
-        free(interp->Y);
+        sim5_arena_free(interp->arena, interp->Y);
+        sim5_arena_free(interp->arena, interp->X);
     }
 
-    if (interp->d2Y) free(interp->d2Y);
-
+    interp->d2Y = NULL;
+    interp->coef = NULL;
+    interp->lnX = NULL;
+    interp->lnY = NULL;
     interp->N = 0;
     interp->capa = 0;
     interp->X = NULL;
@@ -478,6 +954,186 @@ void sim5_interp_free(sim5interp* interp)
 
 
 
+DEVICEFUNC
+int sim5_interpnd_init(sim5interpnd* interp, int ndim, const long n[], double* axes[], const double data[], const int axis_log[], int value_log, int options)
+//! Multi-dimensional interpolation initialization.
+//! Initializes the object `interp` for multilinear interpolation of data given on a rectilinear grid 
+//! of dimension `ndim` (up to INTERP_ND_MAXDIM). Grid points along d-th axis are given by array `axes[d]` 
+//! of size `n[d]`, which must be strictly ordered with increasing values. Data values are given in one contiguous 
+//! array in row-major order (the last axis runs fastest), i.e. the value at grid point (i0,i1,...) has 
+//! index `(i0*n[1] + i1)*n[2] + ...`. Both the axes and the data are copied into the object.
+//! Each axis can be interpolated linearly in x or in log(x) and the values linearly in y or in log(y),
+//! which is the multi-dimensional equivalent of the INTERP_TYPE_xxx types. Grids that are uniform 
+//! (in x or log(x)) along an axis are detected and the index along that axis is calculated directly.
+//!
+//! @param interp interpolation object
+//! @param ndim number of dimensions
+//! @param n array of grid sizes along each axis (at least two points along each axis)
+//! @param axes array of pointers to grid points along each axis
+//! @param data array of values at grid points
+//! @param axis_log array of switches for logarithmic interpolation along each axis (NULL for all linear)
+//! @param value_log switch for logarithmic interpolation in values
+//! @param options interpolation options: INTERP_OPT_CAN_EXTRAPOLATE=extrapolation is allowed
+//!        for points outside of the grid (otherwise the point is moved to the grid boundary)
+//!
+//! @result Returns 0 on success, -1 on error.
+{
+    int d, c;
+    long i, size = 1;
+
+    memset(interp, 0, sizeof(sim5interpnd));
+
+    if ((ndim < 1) || (ndim > INTERP_ND_MAXDIM)) {
+        SIM5_ERROR(SIM5_ERR_OPTION, "sim5_interpnd_init", "unsupported number of dimensions (%d)", ndim);
+        return -1;
+    }
+
+    for (d=0; d<ndim; d++) {
+        if (n[d] < 2) {
+            SIM5_ERROR(SIM5_ERR_GRID, "sim5_interpnd_init", "too few grid points along axis %d (n=%ld)", d, n[d]);
+            return -1;
+        }
+        if ((axis_log) && (axis_log[d]) && (axes[d][0] <= 0.0)) {
+            SIM5_ERROR(SIM5_ERR_RANGE, "sim5_interpnd_init", "non-positive grid point on logarithmic axis %d", d);
+            return -1;
+        }
+        size *= n[d];
+    }
+
+    interp->ndim      = ndim;
+    interp->value_log = value_log;
+    interp->options   = options;
+    interp->arena     = sim5_arena_current();
+
+    // strides (last axis is contiguous) and offsets of corners of a grid cell;
+    // the corner bit of the last axis is the lowest one, so that neighbouring corners are adjacent in memory
+    for (d=ndim-1; d>=0; d--) {
+        interp->n[d] = n[d];
+        interp->stride[d] = (d == ndim-1) ? 1 : interp->stride[d+1]*n[d+1];
+    }
+    for (c=0; c<(1<<ndim); c++) {
+        interp->corner[c] = 0;
+        for (d=0; d<ndim; d++) if ((c >> (ndim-1-d)) & 1) interp->corner[c] += interp->stride[d];
+    }
+
+    // axes (in the coordinate of interpolation) and their index grids;
+    // on failure, the part that has been made is freed by sim5_interpnd_done()
+    interp->data = NULL;
+    for (d=0; d<ndim; d++) {
+        interp->axis_log[d] = (axis_log) ? axis_log[d] : 0;
+        interp->axis[d] = (double*)sim5_arena_malloc(interp->arena, n[d]*sizeof(double));
+        if (!interp->axis[d]) {
+            SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_interpnd_init", "memory allocation failure");
+            interp->ndim = d;
+            sim5_interpnd_done(interp);
+            return -1;
+        }
+        for (i=0; i<n[d]; i++) interp->axis[d][i] = (interp->axis_log[d]) ? log(axes[d][i]) : axes[d][i];
+        sim5_interp_init(&interp->index[d], interp->axis[d], interp->axis[d], n[d], INTERP_DATA_REF, INTERP_TYPE_LINLIN, 0);
+        if (interp->index[d].N == 0) {
+            // sim5_interp_init() has reported the problem (e.g. unordered axis) and left the index empty
+            SIM5_ERROR(SIM5_ERR_GRID, "sim5_interpnd_init", "invalid grid of axis %d", d);
+            interp->ndim = d+1;
+            sim5_interpnd_done(interp);
+            return -1;
+        }
+        // the axis is already in log scale, so a grid uniform in its logarithm gives no advantage
+        if (interp->index[d].grid == INTERP_GRID_LOGUNIFORM) interp->index[d].grid = INTERP_GRID_IRREGULAR;
+    }
+
+    interp->data = (double*)sim5_arena_malloc(interp->arena, size*sizeof(double));
+    if (!interp->data) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_interpnd_init", "memory allocation failure");
+        sim5_interpnd_done(interp);
+        return -1;
+    }
+    for (i=0; i<size; i++) interp->data[i] = (value_log) ? log(data[i]) : data[i];
+
+    return 0;
+}
+
+
+
+DEVICEFUNC
+double sim5_interpnd_eval(sim5interpnd* interp, const double x[])
+//! Multi-dimensional interpolated data evaluation.
+//! Makes the multilinear interpolation at given point. The value is obtained 
+//! by successive linear interpolations between the 2^ndim corners of the grid cell that contains the point.
+//! The interpolation object is not modified, so it can be shared between threads.
+//!
+//! @param interp interpolation object
+//! @param x coordinates of the point (array of size ndim)
+//!
+//! @result Interpolated value.
+{
+    double v[1<<INTERP_ND_MAXDIM];
+    double t[INTERP_ND_MAXDIM];
+    const double* data;
+    int d, c, nc, D = interp->ndim;
+    long base = 0;
+
+    // grid cell and relative position within it along each axis
+    for (d=0; d<D; d++) {
+        const double* a = interp->axis[d];
+        double u = (interp->axis_log[d]) ? log(x[d]) : x[d];
+        long i = sim5_interp_index(&interp->index[d], NULL, u, 0.0);
+        double f = (u - a[i])/(a[i+1] - a[i]);
+        if (!(interp->options & INTERP_OPT_CAN_EXTRAPOLATE)) f = (f < 0.0) ? 0.0 : ((f > 1.0) ? 1.0 : f);
+        t[d] = f;
+        base += i*interp->stride[d];
+    }
+
+    // values at cell corners, reduced axis by axis starting from the last one
+    nc = 1<<D;
+    data = interp->data + base;
+    for (c=0; c<nc; c++) v[c] = data[interp->corner[c]];
+    for (d=D-1; d>=0; d--) {
+        nc /= 2;
+        for (c=0; c<nc; c++) v[c] = v[2*c] + t[d]*(v[2*c+1] - v[2*c]);
+    }
+
+    return (interp->value_log) ? exp(v[0]) : v[0];
+}
+
+
+
+DEVICEFUNC
+void sim5_interpnd_eval_batch(sim5interpnd* interp, const double x[], long n, double y[])
+//! Multi-dimensional interpolated data evaluation for an array of points.
+//! Evaluates the interpolation at `n` points, which gives the same values as calls of sim5_interpnd_eval().
+//!
+//! @param interp interpolation object
+//! @param x coordinates of the points (array of size n*ndim, coordinates of one point are adjacent)
+//! @param n number of points
+//! @param y array of interpolated values (output)
+{
+    long k;
+    for (k=0; k<n; k++) y[k] = sim5_interpnd_eval(interp, x + k*interp->ndim);
+}
+
+
+
+DEVICEFUNC
+void sim5_interpnd_done(sim5interpnd* interp)
+//! Multi-dimensional interpolation finalization.
+//! Frees memory of the interpolation object.
+//!
+//! @param interp interpolation object
+{
+    int d;
+    sim5_arena_free(interp->arena, interp->data);
+    for (d=interp->ndim-1; d>=0; d--) {
+        sim5_interp_done(&interp->index[d]);
+        sim5_arena_free(interp->arena, interp->axis[d]);
+        interp->axis[d] = NULL;
+    }
+    interp->data = NULL;
+    interp->ndim = 0;
+}
+
+
+
+
 
 //#define SIM5FILEIO_TESTING
 #ifdef SIM5FILEIO_TESTING
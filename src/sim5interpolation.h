@@ -26,7 +26,7 @@ extern "C" {
 #define INTERP_DATA_BUILD               2       // X/Y arrays are not passed, they build by calls to sim5_interp_data_push
 
 // interpolation options
-#define INTERP_OPT_ACCEL                1       // interpolation will use acceleration (cashing of index values)
+#define INTERP_OPT_ACCEL                1       // kept for compatibility (index caching is done by a caller-owned sim5interp_accel)
 #define INTERP_OPT_CAN_EXTRAPOLATE      2       // extrapolation is allowed when a value for an of-out-grid point is requested
 
 // interpolation types
@@ -35,6 +35,12 @@ extern "C" {
 #define INTERP_TYPE_LOGLIN              2       // logarithmic interpolation in X, linear in Y
 #define INTERP_TYPE_LOGLOG              3       // logarithmic interpolation in both X and Y
 #define INTERP_TYPE_SPLINE              4       // linear cubic spline interpolation 
+#define INTERP_TYPE_STEFFEN             5       // monotone piecewise cubic interpolation (Steffen 1990)
+
+// grid spacing (detected on initialization)
+#define INTERP_GRID_IRREGULAR           0       // general ordered grid (index is found by bisection)
+#define INTERP_GRID_UNIFORM             1       // grid uniform in X (index is calculated directly)
+#define INTERP_GRID_LOGUNIFORM          2       // grid uniform in log(X) (index is calculated directly)
 
 
 typedef struct sim5interp {
@@ -43,25 +49,59 @@ typedef struct sim5interp {
     double* X;                  // array of grid points
     double* Y;                  // array of values
     double* d2Y;                // array of second derivatives (for spline interpolation only)
+    double* coef;               // array of polynomial coefficients, 4 per interval (for monotone cubic interpolation only)
     int     datamodel;          // data model (INTERP_DATA_xxx)
     int     type;               // interpolation type (INTERP_TYPE_xxx)
     int     options;            // interpolation options (INTERP_OPT_xxx)
     double  xmin;               // minimal value in X grid
     double  xmax;               // maximal value in X grid
-
-    // accelerator:
-    long last_index;            // last found index
+    double* lnX;                // array of log(X) (for interpolation types logarithmic in X)
+    double* lnY;                // array of log(Y) (for interpolation types logarithmic in Y)
+    int     grid;               // grid spacing (INTERP_GRID_xxx)
+    double  grid_x0;            // first grid point, X[0] or log(X[0]) (for uniform grids)
+    double  grid_dx_1;          // inverse grid step in X or log(X) (for uniform grids)
+    sim5arena* arena;           // arena the arrays are allocated from (or NULL for malloc)
 } sim5interp;
 
 
+typedef struct sim5interp_accel {
+    long    last_index;         // last found index
+} sim5interp_accel;
+
+
+#define INTERP_ND_MAXDIM                6       // maximal dimension of multi-dimensional interpolation
+
+typedef struct sim5interpnd {
+    int     ndim;                               // number of dimensions
+    long    n[INTERP_ND_MAXDIM];                // number of grid points along each axis
+    long    stride[INTERP_ND_MAXDIM];           // distance of neighbouring grid points along each axis in data array
+    long    corner[1<<INTERP_ND_MAXDIM];        // offsets of grid cell corners in data array
+    int     axis_log[INTERP_ND_MAXDIM];         // logarithmic interpolation along each axis
+    int     value_log;                          // logarithmic interpolation in values
+    int     options;                            // interpolation options (INTERP_OPT_xxx)
+    double* axis[INTERP_ND_MAXDIM];             // grid points along each axis (log(x) for logarithmic axes)
+    sim5interp index[INTERP_ND_MAXDIM];         // index search along each axis
+    double* data;                               // values at grid points (log(y) for logarithmic values), last axis runs fastest
+    sim5arena* arena;                           // arena the arrays are allocated from (or NULL for malloc)
+} sim5interpnd;
+
+
 DEVICEFUNC sim5interp* sim5_interp_alloc();
 DEVICEFUNC void sim5_interp_init(sim5interp* interp, double xa[], double ya[], long N, int data_model, int interp_type, int interp_options);
 DEVICEFUNC void sim5_interp_data_push(sim5interp* interp, double x, double y);
 DEVICEFUNC double sim5_interp_eval(sim5interp* interp, double x);
+DEVICEFUNC double sim5_interp_eval_accel(sim5interp* interp, sim5interp_accel* acc, double x);
+DEVICEFUNC void sim5_interp_accel_reset(sim5interp_accel* acc);
+DEVICEFUNC void sim5_interp_eval_batch(sim5interp* interp, const double x[], long n, double y[]);
 //DEVICEFUNC double sim5_interp_integral(sim5interp* interp, double a, double b);
 DEVICEFUNC void sim5_interp_done(sim5interp* interp);
 DEVICEFUNC void sim5_interp_free(sim5interp* interp);
 
+DEVICEFUNC int sim5_interpnd_init(sim5interpnd* interp, int ndim, const long n[], double* axes[], const double data[], const int axis_log[], int value_log, int options);
+DEVICEFUNC double sim5_interpnd_eval(sim5interpnd* interp, const double x[]);
+DEVICEFUNC void sim5_interpnd_eval_batch(sim5interpnd* interp, const double x[], long n, double y[]);
+DEVICEFUNC void sim5_interpnd_done(sim5interpnd* interp);
+
 DEVICEFUNC INLINE long sim5_interp_search(const double x_array[], double x, long index_lo, long index_hi);
 
 #ifdef __cplusplus
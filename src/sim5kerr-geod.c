@@ -199,7 +199,7 @@ double geodesic_P_int(geodesic *g, double r, int ppc)
     #ifdef CUDA
     if (r  < g->rp) asm("exit;");
     #else
-    if (r  < g->rp) error("(geodesic_P_int): r < periastron (%.3e < %.3e; nrr=%d)", r, g->rp, g->nrr);
+    if (r  < g->rp) SIM5_ERROR(SIM5_ERR_RANGE, "geodesic_P_int", "r < periastron (%.3e < %.3e; nrr=%d)", r, g->rp, g->nrr);
     #endif
     if (r == g->rp) return g->Rpc;
 
@@ -216,7 +216,7 @@ double geodesic_P_int(geodesic *g, double r, int ppc)
         
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_P_int): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_P_int", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
@@ -253,7 +253,9 @@ double geodesic_P_int(geodesic *g, double r, int ppc)
             mm = 4.*A*B/sqr(A+B);
             R = 2./(A+B) * jacobi_itn((r-r1+r3*g1)/(r3+r1*g1-g1*r), mm);
             if ((R)<0) {
-                fprintf(stderr, "CC: res=%e ppc=%d Rpc=%e R=%e\n", R, ppc, g->Rpc, R);
+                #ifndef CUDA
+                SIM5_ERROR(SIM5_WRN_ACCURACY, "geodesic_P_int", "negative R-integral for GEOD_TYPE_CC (R=%e, ppc=%d, Rpc=%e)", R, ppc, g->Rpc);
+                #endif
             }
             return g->Rpc-R;
     }
@@ -302,7 +304,7 @@ double geodesic_position_rad(geodesic *g, double P)
 
     if ((P<=0.0)||(P>=2.*g->Rpc)) {
         #ifndef CUDA
-        error("(geodesic_position_rad) P out of range (P=%e, 2Rpa=%e)", P, 2*g->Rpc);
+        SIM5_ERROR(SIM5_ERR_RANGE, "geodesic_position_rad", "P out of range (P=%e, 2Rpa=%e)", P, 2*g->Rpc);
         #endif
         return NAN;
     }
@@ -321,13 +323,13 @@ double geodesic_position_rad(geodesic *g, double P)
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_position_rad): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_rad", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_position_rad): not implemented for GEOD_TYPE_RR_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_rad", "not implemented for GEOD_TYPE_RR_BH");
             #endif
             return NAN;
 
@@ -347,7 +349,7 @@ double geodesic_position_rad(geodesic *g, double P)
         
         case GEOD_TYPE_CC:
             #ifndef CUDA
-            error("(geodesic_position_rad): not implemented for GEOD_TYPE_CC");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_rad", "not implemented for GEOD_TYPE_CC");
             #endif
             return NAN;
     }
@@ -391,13 +393,13 @@ double geodesic_position_pol(geodesic *g, double P)
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_pol", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_pol", "not implemented for GEOD_TYPE_BH");
             #endif
             return NAN;
     }
@@ -441,13 +443,13 @@ double geodesic_position_pol_sign_k_theta(geodesic *g, double P)
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_pol_sign_k_theta", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_pol_sign_k_theta", "not implemented for GEOD_TYPE_BH");
             #endif
             return NAN;
     }
@@ -497,13 +499,13 @@ double geodesic_position_azm(geodesic *g, double r, double m, double P)
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_position_azm): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_azm", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_position_azm): not implemented for GEOD_TYPE_RR_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_azm", "not implemented for GEOD_TYPE_RR_BH");
             #endif
             return NAN;
 
@@ -518,7 +520,7 @@ double geodesic_position_azm(geodesic *g, double r, double m, double P)
 
         case GEOD_TYPE_CC:
             #ifndef CUDA
-            error("(geodesic_position_azm): not implemented for GEOD_TYPE_CC");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_position_azm", "not implemented for GEOD_TYPE_CC");
             #endif
             return NAN;
     }
@@ -607,8 +609,8 @@ double geodesic_timedelay(geodesic *g, double P1, double r1, double m1, double P
     //fprintf(stderr,"r1=%e m1=%e P1=%e\n", r1, m1, P1);
     //fprintf(stderr,"r2=%e m2=%e P2=%e\n", r2, m2, P2);
 
-    if (r1 < g->rp) error("geodesic_timedelay: r1 < r_p (%e/%e)", r1, g->rp);
-    if (r2 < g->rp) error("geodesic_timedelay: r2 < r_p (%e/%e)", r2, g->rp);
+    if (r1 < g->rp) SIM5_ERROR(SIM5_ERR_RANGE, "geodesic_timedelay", "r1 < r_p (%e/%e)", r1, g->rp);
+    if (r2 < g->rp) SIM5_ERROR(SIM5_ERR_RANGE, "geodesic_timedelay", "r2 < r_p (%e/%e)", r2, g->rp);
 
     switch (g->type) {
         // trajectories that go to infinity
@@ -629,13 +631,13 @@ double geodesic_timedelay(geodesic *g, double P1, double r1, double m1, double P
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_timedelay): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_timedelay", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_timedelay): not implemented for GEOD_TYPE_RR_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_timedelay", "not implemented for GEOD_TYPE_RR_BH");
             #endif
             return NAN;
 
@@ -655,7 +657,7 @@ double geodesic_timedelay(geodesic *g, double P1, double r1, double m1, double P
 
         case GEOD_TYPE_CC:
             #ifndef CUDA
-            error("(geodesic_timedelay): not implemented for GEOD_TYPE_CC");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_timedelay", "not implemented for GEOD_TYPE_CC");
             #endif
             return NAN;
     }
@@ -765,13 +767,13 @@ double geodesic_dm_sign(geodesic *g, double P)
 
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_dm_sign", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             return NAN;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_dm_sign", "not implemented for GEOD_TYPE_BH");
             #endif
             return NAN;
     }
@@ -823,14 +825,14 @@ void geodesic_momentum(geodesic *g, double P, double r, double m, double k[])
             
         case GEOD_TYPE_RR_DBL:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_RR_DBL");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_momentum", "not implemented for GEOD_TYPE_RR_DBL");
             #endif
             k[0]=k[1]=k[2]=k[3]=NAN;
             return;
 
         case GEOD_TYPE_RR_BH:
             #ifndef CUDA
-            error("(geodesic_dm_sign): not implemented for GEOD_TYPE_BH");
+            SIM5_ERROR(SIM5_ERR_NOT_IMPLEMENTED, "geodesic_momentum", "not implemented for GEOD_TYPE_BH");
             #endif
             k[0]=k[1]=k[2]=k[3]=NAN;
             return;
@@ -866,7 +868,7 @@ double geodesic_find_midplane_crossing(geodesic *g, int order)
     double u = g->cos_i/sqrt(g->m2p);
     if (!ensure_range(&u, -1.0, +1.0, 1e-4)) {
         #ifndef CUDA
-        error("(geodesic_find_midplane_crossing): u out of range (%e)", u);
+        SIM5_ERROR(SIM5_ERR_RANGE, "geodesic_find_midplane_crossing", "u out of range (%e)", u);
         #endif
         return NAN;
     }
@@ -994,6 +996,8 @@ int geodesic_priv_R_roots(geodesic *g, double r0, int *error)
     double l2 = sqr(l);
     double A,B,C,D,E,F,X,Z,z;
 
+    SIM5_TIMER_START(SIM5_TIMER_QUARTIC);
+
     // calculate roots of R(r) after Cadez et al (1998)
     C = sqr(a-l)+q;
     D = 2./3.*(q+l2-a2);
@@ -1014,6 +1018,8 @@ int geodesic_priv_R_roots(geodesic *g, double r0, int *error)
     g->r4 = -B/2. - .5*csqrt(makeComplex(-A+2.*D+4.*C/B,0.0));
     sort_roots(&g->nrr, &g->r1, &g->r2, &g->r3, &g->r4);
 
+    SIM5_TIMER_STOP(SIM5_TIMER_QUARTIC);
+
     // trajectory type
     switch (g->nrr) {
         case 4:
@@ -1021,27 +1027,35 @@ int geodesic_priv_R_roots(geodesic *g, double r0, int *error)
             // r0 can only be between r3 and r2; or it can be above r1
             // anything else is an error
             if ((r0<creal(g->r3)) || ((r0>creal(g->r2)) && (r0<creal(g->r1)))) {
+                SIM5_COUNT(SIM5_STAT_QUARTIC_FAIL);
                 if (error) *error = GD_ERROR_UNKNOWN_SOLUTION;
                 return FALSE;
             }
             // if r1 and r2 are close to each other, it is a double root solution
             if (fabs(creal(g->r1)-creal(g->r2)) < 1e-8) {
+                SIM5_COUNT(SIM5_STAT_QUARTIC_RR_DBL);
                 g->type = GEOD_TYPE_RR_DBL;
                 if (error) *error = GD_ERROR_TYPE_RR_DOUBLE;
                 return FALSE;
             }
             // if r0 is between r3 and r2, it is an inner solution
             if ((r0>=creal(g->r3)) && (r0<=creal(g->r2))) {
+                SIM5_COUNT(SIM5_STAT_QUARTIC_RR_BH);
                 g->type = GEOD_TYPE_RR_BH;
+            } else {
+                SIM5_COUNT(SIM5_STAT_QUARTIC_RR);
             }
             break;
         case 2:
+            SIM5_COUNT(SIM5_STAT_QUARTIC_RC);
             g->type = GEOD_TYPE_RC;
             break;
         case 0:
+            SIM5_COUNT(SIM5_STAT_QUARTIC_CC);
             g->type = GEOD_TYPE_CC;
             break;
         default:
+            SIM5_COUNT(SIM5_STAT_QUARTIC_FAIL);
             if (error) *error = GD_ERROR_UNKNOWN_SOLUTION;
             return FALSE;
     }
@@ -13,15 +13,6 @@
 //! Provides basic routines for doing physics in Kerr and Minkowski spacetimes  (metric, connection, tetrads, 
 //! vector algebra, orbital motion, photon propagation, etc).
 
-//static long prof_N = 0;
-//static double prof_t = 0.0;
-//
-//void sim5kerr_profile() {
-//    fprintf(stderr, "sim5kerr_profile: N=%ld t=%.2e t/N=%.3e\n", prof_N, prof_t, prof_t/(double)(prof_N));
-//}
-
-
-
 //-----------------------------------------------------------------
 // metric, tetrads and vectors
 //-----------------------------------------------------------------
@@ -151,9 +142,7 @@ void kerr_connection(double a, double r, double m, double G[4][4][4])
 //!
 //! @result Connection coeficients are returned in `G` parameter.
 {
-    //prof_N++;
-    //clock_t start_t, end_t;
-    //start_t = clock();
+    SIM5_COUNT(SIM5_STAT_CONNECTION);
 
     double s  = sqrt(1.-m*m);
     double cs = s*m;
@@ -213,9 +202,6 @@ void kerr_connection(double a, double r, double m, double G[4][4][4])
             a4CC*(1. - r))*DR_1;
     G[3][2][3] = ((3.*a4 + 8.*a2*r + 8.*a2r2 + 8.*r4 +
             4.*(dbl_r2 -2.*r + a2)*a2cc + a4CC)*m_s)*R_1;
-
-    //end_t = clock();
-    //prof_t += (end_t - start_t);
 }
 
 
@@ -251,6 +237,226 @@ void flat_connection(double r, double m, double G[4][4][4])
     G[3][2][3] = 2.0 * m/s;
 }
 
+DEVICEFUNC
+void connection_ad(
+    void (*metric_dual)(sim5dual r, sim5dual m, sim5metric_dual *metric, void* params),
+    void* params, double r, double m, double G[4][4][4])
+//! Christoffel symbol components for a general metric (\f$Gamma^\mu_\alpha\beta\f$).
+//! Returns a matrix of connection coefficients for a stationary axisymmetric metric given 
+//! by a user routine. The metric routine is evaluated once with dual numbers seeded 
+//! in r and theta directions, which gives the metric components together with their 
+//! r- and theta-derivatives (forward-mode automatic differentiation) and the connection 
+//! is then assembled from them. The metric has to have the form of Kerr metric in 
+//! Boyer-Lindquist coordinates, i.e. the only non-zero off-diagonal component is g_03.
+//!
+//! The metric routine receives `r` and `m` as dual numbers and has to compute metric 
+//! components with sim5dual arithmetic (dual_add(), dual_mul(), dual_sqrt(), ...).
+//!
+//! (!) NOTE: The result follows the convention of kerr_connection() - only components 
+//! with j<=k are evaluated and those with j<k are multiplied by a factor of two.
+//!
+//! @param metric_dual routine that evaluates metric components in dual numbers
+//! @param params user data that are passed to `metric_dual` (can be NULL)
+//! @param r radial coordinate
+//! @param m poloidal coordinate \f$m=\cos\theta\f$
+//!
+//! @result Connection coeficients are returned in `G` parameter.
+{
+    int i, a, b, c;
+    sim5metric_dual gd;
+    double gi[4][4], dg[3][4][4];
+
+    // evaluate metric and its derivatives (d1=d/dr, d2=d/dtheta; dm/dtheta=-sin(theta))
+    metric_dual(dual_make(r, 1.0, 0.0), dual_make(m, 0.0, -sqrt(1.-m*m)), &gd, params);
+
+    // derivatives of the covariant metric dg[c][a][b] = g_ab,c (c=1,2)
+    for (c=1;c<=2;c++) {
+        dg[c][0][0] = (c==1) ? gd.g00.d1 : gd.g00.d2;
+        dg[c][1][1] = (c==1) ? gd.g11.d1 : gd.g11.d2;
+        dg[c][2][2] = (c==1) ? gd.g22.d1 : gd.g22.d2;
+        dg[c][3][3] = (c==1) ? gd.g33.d1 : gd.g33.d2;
+        dg[c][0][3] = dg[c][3][0] = (c==1) ? gd.g03.d1 : gd.g03.d2;
+    }
+
+    // contravariant metric (the t-phi block is inverted separately)
+    double det_1 = 1./(gd.g00.v*gd.g33.v - sqr(gd.g03.v));
+    gi[0][0] = +gd.g33.v*det_1;
+    gi[3][3] = +gd.g00.v*det_1;
+    gi[0][3] = gi[3][0] = -gd.g03.v*det_1;
+    gi[1][1] = 1./gd.g11.v;
+    gi[2][2] = 1./gd.g22.v;
+
+    // Gamma^i_ab = 1/2 g^ij (g_jb,a + g_ja,b - g_ab,j); only r and theta derivatives are non-zero, 
+    // which leaves three groups of non-zero components
+    memset(G, 0, 4*4*4*sizeof(double));
+    for (i=0;i<4;i+=3) for (a=0;a<4;a+=3) for (c=1;c<=2;c++) {
+        // Gamma^{t,phi}_{(t,phi)(r,theta)}
+        double Gi = gi[i][0]*dg[c][0][a] + gi[i][3]*dg[c][3][a];
+        if (a<c) G[i][a][c] = Gi; else G[i][c][a] = Gi;
+    }
+    for (i=1;i<=2;i++) {
+        // Gamma^{r,theta}_{(t,phi)(t,phi)}
+        G[i][0][0] = -0.5*gi[i][i]*dg[i][0][0];
+        G[i][0][3] = -gi[i][i]*dg[i][0][3];
+        G[i][3][3] = -0.5*gi[i][i]*dg[i][3][3];
+        // Gamma^{r,theta}_{(r,theta)(r,theta)}
+        for (a=1;a<=2;a++) for (b=a;b<=2;b++) {
+            double Gi = gi[i][i]*(((i==b)?dg[a][i][i]:0.0) + ((i==a)?dg[b][i][i]:0.0) - ((a==b)?dg[i][a][a]:0.0));
+            G[i][a][b] = (a<b) ? Gi : 0.5*Gi;
+        }
+    }
+}
+
+
+
+DEVICEFUNC
+void spacetime_kerr(double a, sim5spacetime *st)
+//! Kerr spacetime descriptor.
+//! Sets up a spacetime descriptor for Kerr metric with given spin. Metric and connection
+//! of a Kerr spacetime are evaluated by kerr_metric() and kerr_connection().
+//!
+//! @param a black hole spin
+//!
+//! @result Spacetime descriptor is returned in `st` parameter.
+{
+    st->type       = SPACETIME_KERR;
+    st->a          = a;
+    st->metric     = NULL;
+    st->connection = NULL;
+    st->metric_dual= NULL;
+    st->params     = NULL;
+}
+
+
+
+DEVICEFUNC
+void spacetime_flat(sim5spacetime *st)
+//! Minkowski spacetime descriptor.
+//! Sets up a spacetime descriptor for flat metric. Metric and connection
+//! of a flat spacetime are evaluated by flat_metric() and flat_connection().
+//!
+//! @result Spacetime descriptor is returned in `st` parameter.
+{
+    st->type       = SPACETIME_FLAT;
+    st->a          = 0.0;
+    st->metric     = NULL;
+    st->connection = NULL;
+    st->metric_dual= NULL;
+    st->params     = NULL;
+}
+
+
+
+DEVICEFUNC
+void spacetime_user(
+    void (*metric)(double r, double m, sim5metric *metric, void* params),
+    void (*connection)(double r, double m, double G[4][4][4], void* params),
+    void* params, sim5spacetime *st)
+//! User-defined spacetime descriptor.
+//! Sets up a spacetime descriptor for a stationary axisymmetric metric given by user routines.
+//! The metric has to have the same form as Kerr metric in Boyer-Lindquist coordinates 
+//! (t,r,theta,phi), i.e. the only non-zero off-diagonal component is g_03. The connection routine 
+//! has to follow the convention of kerr_connection() for symmetric lower indices, i.e. it only 
+//! evaluates components with j<=k and multiplies those with j<k by a factor of two.
+//!
+//! @param metric routine that evaluates covariant metric components at (r,m)
+//! @param connection routine that evaluates connection coefficients at (r,m)
+//! @param params user data that are passed to `metric` and `connection` routines (can be NULL)
+//!
+//! @result Spacetime descriptor is returned in `st` parameter.
+{
+    st->type       = SPACETIME_USER;
+    st->a          = 0.0;
+    st->metric     = metric;
+    st->connection = connection;
+    st->metric_dual= NULL;
+    st->params     = params;
+}
+
+
+
+DEVICEFUNC
+void spacetime_user_ad(
+    void (*metric_dual)(sim5dual r, sim5dual m, sim5metric_dual *metric, void* params),
+    void* params, sim5spacetime *st)
+//! User-defined spacetime descriptor with automatic connection.
+//! Sets up a spacetime descriptor for a stationary axisymmetric metric given by a user routine
+//! that evaluates the metric in dual numbers. The connection is then obtained by automatic 
+//! differentiation of the metric [see connection_ad()], so it does not need to be derived by hand.
+//!
+//! @param metric_dual routine that evaluates metric components in dual numbers
+//! @param params user data that are passed to `metric_dual` routine (can be NULL)
+//!
+//! @result Spacetime descriptor is returned in `st` parameter.
+{
+    st->type        = SPACETIME_USER_AD;
+    st->a           = 0.0;
+    st->metric      = NULL;
+    st->connection  = NULL;
+    st->metric_dual = metric_dual;
+    st->params      = params;
+}
+
+
+
+DEVICEFUNC INLINE
+void spacetime_metric(sim5spacetime *st, double r, double m, sim5metric *metric)
+//! Metric of a spacetime.
+//! Returns covariant metric \f$g_\mu\nu\f$ of the spacetime described by `st`.
+//! Built-in spacetimes are dispatched directly to kerr_metric() or flat_metric(), 
+//! so that they do not pay for an indirect call; only user spacetimes are evaluated
+//! through the function pointer of the descriptor.
+//!
+//! @param st spacetime descriptor
+//! @param r radial coordinate
+//! @param m poloidal coordinate \f$m=\cos\theta\f$
+//!
+//! @result Metric components are returned in `metric` parameter.
+{
+    switch (st->type) {
+        case SPACETIME_KERR: kerr_metric(st->a, r, m, metric); break;
+        case SPACETIME_FLAT: flat_metric(r, m, metric); break;
+        case SPACETIME_USER_AD: {
+            sim5metric_dual gd;
+            st->metric_dual(dual_const(r), dual_const(m), &gd, st->params);
+            metric->a   = 0.0;
+            metric->r   = r;
+            metric->m   = m;
+            metric->g00 = gd.g00.v;
+            metric->g11 = gd.g11.v;
+            metric->g22 = gd.g22.v;
+            metric->g33 = gd.g33.v;
+            metric->g03 = gd.g03.v;
+            break;
+        }
+        default: st->metric(r, m, metric, st->params); break;
+    }
+}
+
+
+
+DEVICEFUNC INLINE
+void spacetime_connection(sim5spacetime *st, double r, double m, double G[4][4][4])
+//! Connection of a spacetime.
+//! Returns connection coefficients \f$Gamma^\mu_\alpha\beta\f$ of the spacetime described by `st`
+//! (see kerr_connection() for the convention on symmetric indices). Built-in spacetimes 
+//! are dispatched directly to kerr_connection() or flat_connection().
+//!
+//! @param st spacetime descriptor
+//! @param r radial coordinate
+//! @param m poloidal coordinate \f$m=\cos\theta\f$
+//!
+//! @result Connection coeficients are returned in `G` parameter.
+{
+    switch (st->type) {
+        case SPACETIME_KERR: kerr_connection(st->a, r, m, G); break;
+        case SPACETIME_FLAT: flat_connection(r, m, G); break;
+        case SPACETIME_USER_AD: connection_ad(st->metric_dual, st->params, r, m, G); break;
+        default: st->connection(r, m, G, st->params); break;
+    }
+}
+
+
 /*
 DEVICEFUNC INLINE
 void Gamma(double G[4][4][4], double V[4], double result[4])
@@ -823,6 +1029,317 @@ void on2bl(double Vin[4], double Vout[4], sim5tetrad* t)
 
 
 
+#ifndef CUDA
+//-----------------------------------------------------------------
+// batch (SoA) routines
+//-----------------------------------------------------------------
+// The batch routines do the same work as their single-point counterparts,
+// but operate on arrays of points stored as structure of arrays (SoA).
+// The loops are free of branches and function calls, so that the compiler
+// can vectorize them (note that vectorization of loops with sqrt() 
+// requires -fno-math-errno compiler flag).
+
+
+void sim5metric_batch_alloc(long n, sim5metric_batch *metric)
+//! Allocates metric arrays for a batch of points.
+//! All component arrays are allocated in one memory block; free it with sim5metric_batch_free().
+//!
+//! @param n number of points
+//! @param metric batch metric
+//!
+//! @result Allocated arrays in `metric`.
+{
+    double* block = (double*)malloc(5*n*sizeof(double));
+    metric->a   = 0.0;
+    metric->g00 = block + 0*n;
+    metric->g11 = block + 1*n;
+    metric->g22 = block + 2*n;
+    metric->g33 = block + 3*n;
+    metric->g03 = block + 4*n;
+}
+
+
+void sim5metric_batch_free(sim5metric_batch *metric)
+//! Frees metric arrays allocated with sim5metric_batch_alloc().
+//!
+//! @param metric batch metric
+{
+    free(metric->g00);
+    metric->g00 = metric->g11 = metric->g22 = metric->g33 = metric->g03 = NULL;
+}
+
+
+void sim5tetrad_batch_alloc(long n, sim5tetrad_batch *t)
+//! Allocates tetrad arrays for a batch of points.
+//! All component arrays are allocated in one memory block; free it with sim5tetrad_batch_free().
+//! The `metric` member is not allocated, it is set by tetrad_*_batch() routines.
+//!
+//! @param n number of points
+//! @param t batch tetrad
+//!
+//! @result Allocated arrays in `t`.
+{
+    int i,j;
+    double* block = (double*)malloc(16*n*sizeof(double));
+    for (i=0;i<4;i++) for (j=0;j<4;j++) t->e[i][j] = block + (4*i+j)*n;
+    memset(&t->metric, 0, sizeof(sim5metric_batch));
+}
+
+
+void sim5tetrad_batch_free(sim5tetrad_batch *t)
+//! Frees tetrad arrays allocated with sim5tetrad_batch_alloc().
+//!
+//! @param t batch tetrad
+{
+    int i,j;
+    free(t->e[0][0]);
+    for (i=0;i<4;i++) for (j=0;j<4;j++) t->e[i][j] = NULL;
+}
+
+
+//! \cond SKIP
+// kernels of the batch routines; array arguments are passed as restrict-qualified 
+// function parameters, which allows the compiler to prove that they do not overlap
+
+static void kerr_metric_batch_kernel(long n, double a, const double* restrict r, const double* restrict m,
+    double* restrict g00, double* restrict g11, double* restrict g22, double* restrict g33, double* restrict g03)
+{
+    long i;
+    double a2 = sqr(a);
+    for (i=0; i<n; i++) {
+        double r2  = sqr(r[i]);
+        double m2  = sqr(m[i]);
+        double S   = r2 + a2*m2;
+        double s2S = (1.0-m2)/S;
+        g00[i] = -1. + 2.0*r[i]/S;
+        g11[i] = S/(r2-2.*r[i]+a2);
+        g22[i] = S;
+        g33[i] = (r2*r2 + a2*a2*m2 + a2*r2*(1.+m2) + 2.*r[i]*a2*s2S*S)*s2S;
+        g03[i] = -2.*a*r[i]*s2S;
+    }
+}
+
+
+static void tetrad_azimuthal_batch_kernel(long n, const double* restrict Omega,
+    const double* restrict g00, const double* restrict g11, const double* restrict g22, const double* restrict g33, const double* restrict g03,
+    double* restrict e00, double* restrict e03, double* restrict e11, double* restrict e22, double* restrict e30, double* restrict e33)
+{
+    long i;
+    for (i=0; i<n; i++) {
+        double U0 = sqrt(-1.0/(g00[i] + 2.*Omega[i]*g03[i] + sqr(Omega[i])*g33[i]));
+        double U3 = U0*Omega[i];
+        double k1 = (g03[i]*U3+g00[i]*U0);
+        double k2 = (g33[i]*U3+g03[i]*U0);
+        double E30 = - copysign(1.0,k1)*k2 / sqrt((g33[i]*g00[i]-g03[i]*g03[i])*(g00[i]*U0*U0+g33[i]*U3*U3+2.0*g03[i]*U0*U3));
+        double E33 = E30*(-k1/k2);
+        // ZAMO for Omega=0 (all values are computed and then selected to keep the loop branch-free)
+        double Z00 = sqrt(g33[i]/(sqr(g03[i]) - g33[i]*g00[i]));
+        double Z03 = -Z00*g03[i]/g33[i];
+        double Z33 = 1./sqrt(g33[i]);
+        int zamo = (Omega[i] == 0.0);
+        e00[i] = zamo ? Z00 : U0;
+        e03[i] = zamo ? Z03 : U3;
+        e11[i] = sqrt(1./g11[i]);
+        e22[i] = -sqrt(1./g22[i]);
+        e30[i] = zamo ? 0.0 : E30;
+        e33[i] = zamo ? Z33 : E33;
+    }
+}
+
+
+static void tetrad_surface_batch_kernel(long n, const double* restrict Omega, const double* restrict V, const double* restrict dhdr,
+    const double* restrict g00, const double* restrict g11, const double* restrict g22, const double* restrict g33, const double* restrict g03,
+    double* restrict e00, double* restrict e01, double* restrict e02, double* restrict e03,
+    double* restrict e10, double* restrict e11, double* restrict e12, double* restrict e13,
+    double* restrict e21, double* restrict e22, double* restrict e30, double* restrict e33)
+{
+    long i;
+    for (i=0; i<n; i++) {
+        double W = Omega[i];
+        double S0r = 1.0/sqrt(g11[i]+g22[i]*sqr(dhdr[i]));
+        double S0h = S0r*dhdr[i];
+        double ur  = V[i]/sqrt(1.-V[i]*V[i])/sqrt(g11[i]);
+        double q2  = sqr(ur/S0r);
+        double v   = copysign(1.0,V[i]) * sqrt((q2*(-g00[i]-2.*W*g03[i]-sqr(W)*g33[i]))/(1.+q2));
+        double N;
+
+        // 4-velocity U
+        double U0 = 1.0;
+        double U1 = v*S0r;
+        double U2 = v*S0h;
+        double U3 = W;
+        N = sqrt(-1.0/(g00[i] + g11[i]*U1*U1 + g22[i]*U2*U2 + g33[i]*U3*U3 + 2.*g03[i]*U3));
+        U0 *= N; U1 *= N; U2 *= N; U3 *= N;
+        e00[i] = U0; e01[i] = U1; e02[i] = U2; e03[i] = U3;
+
+        // surface tangent vector S
+        double S0 = v*U0;
+        double S1 = v*U1 + S0r/U0;
+        double S2 = v*U2 + S0h/U0;
+        double S3 = v*U3;
+        N = sqrt(1.0/(g00[i]*S0*S0 + g11[i]*S1*S1 + g22[i]*S2*S2 + g33[i]*S3*S3 + 2.*g03[i]*S0*S3));
+        e10[i] = S0*N; e11[i] = S1*N; e12[i] = S2*N; e13[i] = S3*N;
+
+        // surface normal vector N
+        N = sqrt(1.0/(g11[i]*sqr(dhdr[i]) + g22[i]));
+        e21[i] = dhdr[i]*N; e22[i] = -N;
+
+        // the remaining [t,phi] plane vector K
+        double K0 = -(g03[i]+g33[i]*W)/(g00[i]+g03[i]*W);
+        N = sqrt(1.0/(g00[i]*K0*K0 + 2.*g03[i]*K0 + g33[i]));
+        e30[i] = K0*N; e33[i] = N;
+    }
+}
+
+
+static void bl2on_batch_kernel(long n, double sgn, 
+    const double* restrict V0, const double* restrict V1, const double* restrict V2, const double* restrict V3,
+    const double* restrict e0, const double* restrict e1, const double* restrict e2, const double* restrict e3,
+    const double* restrict g00, const double* restrict g11, const double* restrict g22, const double* restrict g33, const double* restrict g03,
+    double* restrict out)
+{
+    long i;
+    for (i=0; i<n; i++) {
+        out[i] = sgn*(e0[i]*V0[i]*g00[i] + e1[i]*V1[i]*g11[i] + e2[i]*V2[i]*g22[i] +
+                      e3[i]*V3[i]*g33[i] + (e0[i]*V3[i] + e3[i]*V0[i])*g03[i]);
+    }
+}
+
+
+static void on2bl_batch_kernel(long n,
+    const double* restrict V0, const double* restrict V1, const double* restrict V2, const double* restrict V3,
+    const double* restrict e0, const double* restrict e1, const double* restrict e2, const double* restrict e3,
+    double* restrict out)
+{
+    long i;
+    for (i=0; i<n; i++) out[i] = V0[i]*e0[i] + V1[i]*e1[i] + V2[i]*e2[i] + V3[i]*e3[i];
+}
+
+
+static void zero_batch_kernel(long n, double* restrict x)
+{
+    long i;
+    for (i=0; i<n; i++) x[i] = 0.0;
+}
+//! \endcond
+
+
+void kerr_metric_batch(double a, double r[], double m[], long n, sim5metric_batch *metric)
+//! Kerr spacetime metric for a batch of points.
+//! Batch version of kerr_metric().
+//!
+//! @param a black hole spin
+//! @param r array of radial coordinates
+//! @param m array of poloidal coordinates \f$m=\cos\theta\f$
+//! @param n number of points
+//! @param metric batch metric (arrays must be allocated for at least `n` points)
+//!
+//! @result Metric components are returned in `metric` parameter.
+{
+    metric->a = a;
+    kerr_metric_batch_kernel(n, a, r, m, metric->g00, metric->g11, metric->g22, metric->g33, metric->g03);
+}
+
+
+void tetrad_azimuthal_batch(sim5metric_batch *m, double Omega[], long n, sim5tetrad_batch *t)
+//! Tetrad of observer that moves purely in azimuthal direction for a batch of points.
+//! Batch version of tetrad_azimuthal(); as there, the ZAMO tetrad is given for points with Omega=0.
+//!
+//! @param m batch metric
+//! @param Omega array of angular velocities in [g.u.]
+//! @param n number of points
+//! @param t batch tetrad (arrays must be allocated for at least `n` points)
+//!
+//! @result Returns tetrad vectors in `t`.
+{
+    tetrad_azimuthal_batch_kernel(n, Omega, m->g00, m->g11, m->g22, m->g33, m->g03,
+        t->e[0][0], t->e[0][3], t->e[1][1], t->e[2][2], t->e[3][0], t->e[3][3]);
+
+    zero_batch_kernel(n, t->e[0][1]);
+    zero_batch_kernel(n, t->e[0][2]);
+    zero_batch_kernel(n, t->e[1][0]);
+    zero_batch_kernel(n, t->e[1][2]);
+    zero_batch_kernel(n, t->e[1][3]);
+    zero_batch_kernel(n, t->e[2][0]);
+    zero_batch_kernel(n, t->e[2][1]);
+    zero_batch_kernel(n, t->e[2][3]);
+    zero_batch_kernel(n, t->e[3][1]);
+    zero_batch_kernel(n, t->e[3][2]);
+
+    t->metric = *m;
+}
+
+
+void tetrad_surface_batch(sim5metric_batch *m, double Omega[], double V[], double dhdr[], long n, sim5tetrad_batch *t)
+//! Tetrad of observer that moves along a surface for a batch of points.
+//! Batch version of tetrad_surface().
+//!
+//! @param m batch metric
+//! @param Omega array of angular velocities in [g.u.]
+//! @param V array of radial drift velocities mesured in corotating frame [c]
+//! @param dhdr array of surface slopes dH/dR
+//! @param n number of points
+//! @param t batch tetrad (arrays must be allocated for at least `n` points)
+//!
+//! @result Returns tetrad vectors in `t`.
+{
+    tetrad_surface_batch_kernel(n, Omega, V, dhdr, m->g00, m->g11, m->g22, m->g33, m->g03,
+        t->e[0][0], t->e[0][1], t->e[0][2], t->e[0][3],
+        t->e[1][0], t->e[1][1], t->e[1][2], t->e[1][3],
+        t->e[2][1], t->e[2][2], t->e[3][0], t->e[3][3]);
+
+    zero_batch_kernel(n, t->e[2][0]);
+    zero_batch_kernel(n, t->e[2][3]);
+    zero_batch_kernel(n, t->e[3][1]);
+    zero_batch_kernel(n, t->e[3][2]);
+
+    t->metric = *m;
+}
+
+
+void bl2on_batch(double *Vin[4], double *Vout[4], sim5tetrad_batch *t, long n)
+//! Vector transformation from coordinate to local frame for a batch of points.
+//! Batch version of bl2on(). Vector components are given as four arrays, 
+//! i.e. `Vin[j][i]` is the j-th component of the vector at i-th point.
+//!
+//! @param Vin vectors to transform (in coordinate basis) 
+//! @param Vout transformed vectors (in local basis)
+//! @param t batch tetrad
+//! @param n number of points
+//!
+//! @result Local vectors Vout.
+{
+    int a;
+    for (a=0; a<4; a++) {
+        bl2on_batch_kernel(n, (a==0) ? -1.0 : +1.0, Vin[0], Vin[1], Vin[2], Vin[3],
+            t->e[a][0], t->e[a][1], t->e[a][2], t->e[a][3],
+            t->metric.g00, t->metric.g11, t->metric.g22, t->metric.g33, t->metric.g03, Vout[a]);
+    }
+}
+
+
+void on2bl_batch(double *Vin[4], double *Vout[4], sim5tetrad_batch *t, long n)
+//! Vector transformation from local to coordinate frame for a batch of points.
+//! Batch version of on2bl(). Vector components are given as four arrays, 
+//! i.e. `Vin[j][i]` is the j-th component of the vector at i-th point.
+//!
+//! @param Vin vectors to transform (in local basis) 
+//! @param Vout transformed vectors (in coordinate basis)
+//! @param t batch tetrad
+//! @param n number of points
+//!
+//! @result Coordinate vectors Vout.
+{
+    int j;
+    for (j=0; j<4; j++) {
+        on2bl_batch_kernel(n, Vin[0], Vin[1], Vin[2], Vin[3], t->e[0][j], t->e[1][j], t->e[2][j], t->e[3][j], Vout[j]);
+    }
+}
+#endif
+
+
+
+
 //-----------------------------------------------------------------
 // orbital motion
 //-----------------------------------------------------------------
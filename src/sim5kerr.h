@@ -32,6 +32,55 @@ struct sim5tetrad {
 typedef struct sim5tetrad sim5tetrad;
 
 
+#ifndef CUDA
+// metric components for a batch of points (structure of arrays)
+struct sim5metric_batch {
+    double a;               // black hole spin
+    double *g00;            // arrays of metric components (one element per point)
+    double *g11;
+    double *g22;
+    double *g33;
+    double *g03;
+};
+typedef struct sim5metric_batch sim5metric_batch;
+
+// tetrads for a batch of points (structure of arrays)
+struct sim5tetrad_batch {
+    double *e[4][4];        // e[i][j] is an array of j-th components of i-th tetrad vector
+    sim5metric_batch metric;// metric arrays the tetrads have been evaluated with
+};
+typedef struct sim5tetrad_batch sim5tetrad_batch;
+#endif
+
+
+// metric with components and their derivatives (for automatic differentiation)
+struct sim5metric_dual {
+    sim5dual g00;
+    sim5dual g11;
+    sim5dual g22;
+    sim5dual g33;
+    sim5dual g03;
+};
+typedef struct sim5metric_dual sim5metric_dual;
+
+
+// spacetime types
+#define SPACETIME_KERR          0         // Kerr metric
+#define SPACETIME_FLAT          1         // Minkowski (flat) metric
+#define SPACETIME_USER          2         // stationary axisymmetric metric supplied by user
+#define SPACETIME_USER_AD       3         // user metric with connection by automatic differentiation
+
+struct sim5spacetime {
+    int type;               // spacetime type (SPACETIME_KERR, SPACETIME_FLAT, SPACETIME_USER or SPACETIME_USER_AD)
+    double a;               // black hole spin (for SPACETIME_KERR)
+    void (*metric)(double r, double m, sim5metric *metric, void* params);       // metric (for SPACETIME_USER)
+    void (*connection)(double r, double m, double G[4][4][4], void* params);    // connection (for SPACETIME_USER)
+    void (*metric_dual)(sim5dual r, sim5dual m, sim5metric_dual *metric, void* params); // metric (for SPACETIME_USER_AD)
+    void* params;           // user parameters passed to metric(), connection() and metric_dual()
+};
+typedef struct sim5spacetime sim5spacetime;
+
+
 
 DEVICEFUNC
 void flat_metric(double r, double m, sim5metric *metric);
@@ -51,6 +100,34 @@ void flat_connection(double r, double m, double G[4][4][4]);
 DEVICEFUNC
 void kerr_connection(double a, double r, double m, double G[4][4][4]);
 
+DEVICEFUNC
+void connection_ad(
+    void (*metric_dual)(sim5dual r, sim5dual m, sim5metric_dual *metric, void* params),
+    void* params, double r, double m, double G[4][4][4]);
+
+DEVICEFUNC
+void spacetime_kerr(double a, sim5spacetime *st);
+
+DEVICEFUNC
+void spacetime_flat(sim5spacetime *st);
+
+DEVICEFUNC
+void spacetime_user(
+    void (*metric)(double r, double m, sim5metric *metric, void* params),
+    void (*connection)(double r, double m, double G[4][4][4], void* params),
+    void* params, sim5spacetime *st);
+
+DEVICEFUNC
+void spacetime_user_ad(
+    void (*metric_dual)(sim5dual r, sim5dual m, sim5metric_dual *metric, void* params),
+    void* params, sim5spacetime *st);
+
+DEVICEFUNC INLINE
+void spacetime_metric(sim5spacetime *st, double r, double m, sim5metric *metric);
+
+DEVICEFUNC INLINE
+void spacetime_connection(sim5spacetime *st, double r, double m, double G[4][4][4]);
+
 DEVICEFUNC INLINE
 void Gamma(double G[4][4][4], double U[4], double V[4], double result[4]);
 
@@ -103,6 +180,24 @@ DEVICEFUNC
 void on2bl(double Vin[4], double Vout[4], sim5tetrad* t);
 
 
+#ifndef CUDA
+//-----------------------------------------------------------------
+// batch (SoA) routines
+//-----------------------------------------------------------------
+
+void sim5metric_batch_alloc(long n, sim5metric_batch *metric);
+void sim5metric_batch_free(sim5metric_batch *metric);
+void sim5tetrad_batch_alloc(long n, sim5tetrad_batch *t);
+void sim5tetrad_batch_free(sim5tetrad_batch *t);
+
+void kerr_metric_batch(double a, double r[], double m[], long n, sim5metric_batch *metric);
+void tetrad_azimuthal_batch(sim5metric_batch *m, double Omega[], long n, sim5tetrad_batch *t);
+void tetrad_surface_batch(sim5metric_batch *m, double Omega[], double V[], double dhdr[], long n, sim5tetrad_batch *t);
+void bl2on_batch(double *Vin[4], double *Vout[4], sim5tetrad_batch *t, long n);
+void on2bl_batch(double *Vin[4], double *Vout[4], sim5tetrad_batch *t, long n);
+#endif
+
+
 //-----------------------------------------------------------------
 // orbital motion
 //-----------------------------------------------------------------
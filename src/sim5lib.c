@@ -17,8 +17,10 @@
 
 
 // sim5lib parts
+#include "sim5random.c"
 #include "sim5math.c"
 #include "sim5utils.c"
+#include "sim5profile.c"
 #include "sim5integration.c"
 
 #ifndef CUDA
@@ -35,6 +37,7 @@
 
 #ifndef CUDA
 #include "sim5disk-nt.c"
+#include "sim5disk-table.c"
 #endif
 
 #include "sim5polarization.c"
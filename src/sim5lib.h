@@ -21,8 +21,10 @@
 
 // sim5lib parts
 #include "sim5const.h"
+#include "sim5random.h"
 #include "sim5math.h"
 #include "sim5utils.h"
+#include "sim5profile.h"
 #include "sim5integration.h"
 
 #ifndef CUDA
@@ -33,12 +35,13 @@
 #include "sim5roots.h"
 #include "sim5elliptic.h"
 #include "sim5polyroots.h"
-#include "sim5raytrace.h"
 #include "sim5kerr.h"
+#include "sim5raytrace.h"
 #include "sim5kerr-geod.h"
 
 #ifndef CUDA
 #include "sim5disk-nt.h"
+#include "sim5disk-table.h"
 #endif
 
 #include "sim5polarization.h"
@@ -59,6 +59,13 @@ int ensure_range(double *val, double min, double max, double acc)
 
 
 
+#ifdef CUDA
+//! \cond SKIP
+#define SIM5RAND_CUDA_SEED 0x4d544750
+__device__ static unsigned long long sim5rand_counter = 0;
+//! \endcond
+#endif
+
 DEVICEFUNC INLINE 
 void sim5seed()
 // see http://stackoverflow.com/questions/11832202/cuda-random-number-generating
@@ -77,21 +84,16 @@ unsigned long long sim5rand()
     #ifndef CUDA
     return mt19937_int64();
     #else
-
-    static long rndseed = 0x4d544750;
-    #if LONG_MAX > (16807*2147483647)
-    int const a    = 16807;      //ie 7**5
-    int const m    = 2147483647; //ie 2**31-1
-	rndseed = ((long)(rndseed * a))%m;
-	return rndseed;
-    #else
-    double const a    = 16807;      //ie 7**5
-    double const m    = 2147483647; //ie 2**31-1
-	double temp = rndseed * a;
-	rndseed = (int) (temp - m * floor ( temp / m ));
-	return rndseed;
-    #endif
-
+    // draw a unique counter value for each call, so that concurrent threads never share
+    // a number (threads that need reproducible sequences should use their own sim5rng stream)
+    uint32_t key[2] = {SIM5RAND_CUDA_SEED, 0};
+    uint32_t ctr[4] = {0, 0, 0, 0};
+    uint32_t out[4];
+    unsigned long long i = atomicAdd(&sim5rand_counter, 1ULL);
+    ctr[0] = (uint32_t)i;
+    ctr[1] = (uint32_t)(i>>32);
+    philox4x32(ctr, key, out);
+    return (unsigned long long)out[0] | ((unsigned long long)out[1]<<32);
     #endif
 }
 
@@ -102,26 +104,171 @@ double sim5urand()
     #ifndef CUDA
     return mt19937_real1();
     #else
+    return ((sim5rand() >> 12) + 0.5) * 0x1p-52;
+    #endif
+}
 
-    static long rndseed = 0x4d544750;
-    #if LONG_MAX > (16807*2147483647)
-    int const a    = 16807;      //ie 7**5
-    int const m    = 2147483647; //ie 2**31-1
-	rndseed = ((long)(rndseed * a))%m;
-	return (double)(rndseed)/(double)(m);
+
+
+//! \cond SKIP
+#ifndef CUDA
+#define SIM5RAND_CHUNK 256
+#else
+#define SIM5RAND_CHUNK 16
+#endif
+
+DEVICEFUNC INLINE static
+void sim5rand_fill(unsigned long long* r, size_t n)
+// n raw 64-bit numbers from the same generator as sim5rand()
+{
+    #ifndef CUDA
+    mt19937_fill_int64(r, n);
     #else
-    double const a    = 16807;      //ie 7**5
-    double const m    = 2147483647; //ie 2**31-1
-	double temp = rndseed * a;
-	rndseed = (int) (temp - m * floor ( temp / m ));
-	return (double)(rndseed)/m;
+    size_t i;
+    for (i=0; i<n; i++) r[i] = sim5rand();
     #endif
+}
+
+DEVICEFUNC INLINE static
+double sim5rand_u52_to_double(unsigned long long k)
+// exact conversion of k<2^52 to double via the bit pattern of 2^52+k (vectorizes, unlike a cast)
+{
+    union { unsigned long long i; double d; } u;
+    u.i = 0x4330000000000000ULL | k;
+    return u.d - 4503599627370496.0;
+}
+
+DEVICEFUNC INLINE static
+double sim5rand_closed(unsigned long long r)
+// number on [0,1]-interval, identical to mt19937_real1()
+{
+    unsigned long long k = r >> 11;
+    return (sim5rand_u52_to_double(k>>26)*67108864.0 + sim5rand_u52_to_double(k&0x3ffffffULL)) * (1.0/9007199254740991.0);
+}
+
+DEVICEFUNC INLINE static
+double sim5rand_open(unsigned long long r)
+// number on (0,1)-interval (safe for logarithm)
+{
+    return (sim5rand_u52_to_double(r>>12) + 0.5) * 0x1p-52;
+}
+//! \endcond
+
 
+
+DEVICEFUNC
+void sim5_urand_fill(double* out, size_t n)
+//! Fills an array with random numbers from uniform distribution.
+//!
+//! Gives the same numbers as `n` calls of sim5urand(), but the generator state is consumed
+//! in blocks and the conversion to double precision is done in a loop that vectorizes.
+//!
+//! @param out output array
+//! @param n number of values
+{
+    #ifndef CUDA
+    unsigned long long r[SIM5RAND_CHUNK];
+    size_t i, k;
+    while (n > 0) {
+        k = (n < SIM5RAND_CHUNK) ? n : SIM5RAND_CHUNK;
+        sim5rand_fill(r, k);
+        for (i=0; i<k; i++) out[i] = sim5rand_closed(r[i]);
+        out += k;
+        n -= k;
+    }
+    #else
+    size_t i;
+    for (i=0; i<n; i++) out[i] = sim5urand();
     #endif
 }
 
 
 
+DEVICEFUNC
+void sim5_nrand_fill(double* out, size_t n)
+//! Fills an array with random numbers from normal distribution.
+//!
+//! Draws numbers from the standard normal distribution (zero mean, unit variance)
+//! using Box-Muller transformation of pairs of uniform numbers.
+//!
+//! @param out output array
+//! @param n number of values
+{
+    unsigned long long r[SIM5RAND_CHUNK];
+    size_t i, k;
+    while (n > 0) {
+        k = (n < SIM5RAND_CHUNK) ? n : SIM5RAND_CHUNK;
+        k += (k & 1);
+        sim5rand_fill(r, k);
+        for (i=0; i<k/2; i++) {
+            double rho = sqrt(-2.0*log(sim5rand_open(r[2*i])));
+            double phi = PI2*sim5rand_open(r[2*i+1]);
+            out[2*i] = rho*cos(phi);
+            if (2*i+1 < n) out[2*i+1] = rho*sin(phi);
+        }
+        if (k > n) k = n;
+        out += k;
+        n -= k;
+    }
+}
+
+
+
+DEVICEFUNC
+void sim5_erand_fill(double* out, size_t n)
+//! Fills an array with random numbers from exponential distribution.
+//!
+//! Draws numbers from the exponential distribution with unit mean, i.e. with
+//! probability density exp(-x) for x>0.
+//!
+//! @param out output array
+//! @param n number of values
+{
+    unsigned long long r[SIM5RAND_CHUNK];
+    size_t i, k;
+    while (n > 0) {
+        k = (n < SIM5RAND_CHUNK) ? n : SIM5RAND_CHUNK;
+        sim5rand_fill(r, k);
+        for (i=0; i<k; i++) out[i] = -log(sim5rand_open(r[i]));
+        out += k;
+        n -= k;
+    }
+}
+
+
+
+DEVICEFUNC
+void sim5_isotropic_fill(double* dir, size_t n)
+//! Fills an array with random isotropic directions.
+//!
+//! Generates unit vectors uniformly distributed over the sphere.
+//! Components of i-th vector are stored in dir[3*i+0], dir[3*i+1] and dir[3*i+2] (x,y,z).
+//!
+//! @param dir output array of size 3*n
+//! @param n number of directions
+{
+    unsigned long long r[SIM5RAND_CHUNK];
+    size_t i, k;
+    while (n > 0) {
+        k = (n < SIM5RAND_CHUNK/2) ? n : SIM5RAND_CHUNK/2;
+        sim5rand_fill(r, 2*k);
+        for (i=0; i<k; i++) {
+            double mu  = 2.0*sim5rand_closed(r[2*i]) - 1.0;
+            double phi = PI2*sim5rand_open(r[2*i+1]);
+            double s   = sqrt(fmax(0.0, 1.0-mu*mu));
+            dir[3*i+0] = s*cos(phi);
+            dir[3*i+1] = s*sin(phi);
+            dir[3*i+2] = mu;
+        }
+        dir += 3*k;
+        n -= k;
+    }
+}
+
+#undef SIM5RAND_CHUNK
+
+
+
 /*
 #ifdef CUDA
     __device__
@@ -178,6 +325,145 @@ void cartesian2spherical2(double cos_h, double sin_f, double cos_f, double Vx, d
 
 
 
+//---------------------------------------------------------------------
+// dual numbers (forward-mode automatic differentiation)
+//---------------------------------------------------------------------
+// A sim5dual carries value v and partial derivatives (d1,d2) with respect 
+// to two independent variables. Seeding the variables as dual_make(x,1,0) 
+// and dual_make(y,0,1) and evaluating an expression with the routines 
+// below gives the expression value together with its gradient.
+
+
+DEVICEFUNC INLINE
+sim5dual dual_make(double v, double d1, double d2)
+{
+    sim5dual res;
+    res.v  = v;
+    res.d1 = d1;
+    res.d2 = d2;
+    return res;
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_const(double v)
+{
+    return dual_make(v, 0.0, 0.0);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_add(sim5dual a, sim5dual b)
+{
+    return dual_make(a.v+b.v, a.d1+b.d1, a.d2+b.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_sub(sim5dual a, sim5dual b)
+{
+    return dual_make(a.v-b.v, a.d1-b.d1, a.d2-b.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_mul(sim5dual a, sim5dual b)
+{
+    return dual_make(a.v*b.v, a.d1*b.v+a.v*b.d1, a.d2*b.v+a.v*b.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_div(sim5dual a, sim5dual b)
+{
+    double ib = 1./b.v;
+    double q  = a.v*ib;
+    return dual_make(q, (a.d1-q*b.d1)*ib, (a.d2-q*b.d2)*ib);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_addc(sim5dual a, double c)
+{
+    return dual_make(a.v+c, a.d1, a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_mulc(sim5dual a, double c)
+{
+    return dual_make(a.v*c, a.d1*c, a.d2*c);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_inv(sim5dual a)
+{
+    double ia = 1./a.v;
+    double d  = -ia*ia;
+    return dual_make(ia, d*a.d1, d*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_sqr(sim5dual a)
+{
+    return dual_make(a.v*a.v, 2.*a.v*a.d1, 2.*a.v*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_sqrt(sim5dual a)
+{
+    double s = sqrt(a.v);
+    double d = 0.5/s;
+    return dual_make(s, d*a.d1, d*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_pow(sim5dual a, double p)
+{
+    double f = pow(a.v, p);
+    double d = p*pow(a.v, p-1.);
+    return dual_make(f, d*a.d1, d*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_exp(sim5dual a)
+{
+    double e = exp(a.v);
+    return dual_make(e, e*a.d1, e*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_log(sim5dual a)
+{
+    double ia = 1./a.v;
+    return dual_make(log(a.v), ia*a.d1, ia*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_sin(sim5dual a)
+{
+    double c = cos(a.v);
+    return dual_make(sin(a.v), c*a.d1, c*a.d2);
+}
+
+
+DEVICEFUNC INLINE
+sim5dual dual_cos(sim5dual a)
+{
+    double s = -sin(a.v);
+    return dual_make(cos(a.v), s*a.d1, s*a.d2);
+}
+
+
+
+
 //---------------------------------------------------------------------
 // complex algebra
 //---------------------------------------------------------------------
@@ -63,6 +63,16 @@ extern "C" {
 #endif
 
 
+//! Dual number for forward-mode automatic differentiation.
+//! Carries a value together with its first derivatives with respect to two independent
+//! variables, so that derivatives in both directions are propagated in a single pass.
+typedef struct sim5dual {
+    double v;               //!< value
+    double d1;              //!< derivative with respect to the first variable
+    double d2;              //!< derivative with respect to the second variable
+} sim5dual;
+
+
 //! \cond SKIP
 DEVICEFUNC INLINE long sim5round(double num);
 
@@ -81,6 +91,28 @@ DEVICEFUNC void cartesian2spherical2(double cos_h, double sin_f, double cos_f, d
 DEVICEFUNC INLINE void sim5seed();
 DEVICEFUNC INLINE unsigned long long sim5rand();
 DEVICEFUNC INLINE double sim5urand();
+DEVICEFUNC void sim5_urand_fill(double* out, size_t n);
+DEVICEFUNC void sim5_nrand_fill(double* out, size_t n);
+DEVICEFUNC void sim5_erand_fill(double* out, size_t n);
+DEVICEFUNC void sim5_isotropic_fill(double* dir, size_t n);
+
+
+DEVICEFUNC INLINE sim5dual dual_make(double v, double d1, double d2);
+DEVICEFUNC INLINE sim5dual dual_const(double v);
+DEVICEFUNC INLINE sim5dual dual_add(sim5dual a, sim5dual b);
+DEVICEFUNC INLINE sim5dual dual_sub(sim5dual a, sim5dual b);
+DEVICEFUNC INLINE sim5dual dual_mul(sim5dual a, sim5dual b);
+DEVICEFUNC INLINE sim5dual dual_div(sim5dual a, sim5dual b);
+DEVICEFUNC INLINE sim5dual dual_addc(sim5dual a, double c);
+DEVICEFUNC INLINE sim5dual dual_mulc(sim5dual a, double c);
+DEVICEFUNC INLINE sim5dual dual_inv(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_sqr(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_sqrt(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_pow(sim5dual a, double p);
+DEVICEFUNC INLINE sim5dual dual_exp(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_log(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_sin(sim5dual a);
+DEVICEFUNC INLINE sim5dual dual_cos(sim5dual a);
 
 
 DEVICEFUNC INLINE sim5complex makeComplex(double r, double i);
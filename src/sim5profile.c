@@ -0,0 +1,171 @@
+//************************************************************************
+//    sim5profile.c - profiling counters and timers
+//************************************************************************
+
+
+//! \file sim5profile.c
+//! Profiling counters and timers
+//!
+//! Provides optional counters of expensive events (connection evaluations, RK4 fallbacks in raytracing,
+//! elliptic integrals, root solves of geodesics, interpolation searches) and timers of major routines.
+//! The profiling is disabled by default and all the counting compiles out to nothing; it is enabled
+//! by defining SIM5_PROFILE in sim5config.h (or by -DSIM5_PROFILE). Each thread counts into its
+//! own block of counters, so the counting needs no synchronization; the blocks are kept after
+//! the thread exits and sim5_stats_dump() gives the sum over all threads.
+
+
+#ifndef CUDA
+//! \cond SKIP
+static sim5stats* sim5stats_list = NULL;
+
+#ifdef SIM5_PROFILE
+static const char* sim5stats_counter_names[SIM5_STAT_COUNT] = {
+    "kerr connection",
+    "raytrace steps",
+    "raytrace RK4 fallbacks",
+    "elliptic integral calls",
+    "elliptic integral iterations",
+    "R-roots GEOD_TYPE_RR",
+    "R-roots GEOD_TYPE_RR_DBL",
+    "R-roots GEOD_TYPE_RR_BH",
+    "R-roots GEOD_TYPE_RC",
+    "R-roots GEOD_TYPE_CC",
+    "R-roots failed",
+    "interpolation searches",
+    "interpolation direct lookups",
+};
+
+static const char* sim5stats_timer_names[SIM5_TIMER_COUNT] = {
+    "raytrace",
+    "raytrace_rk4",
+    "R-roots solve",
+    "sim5_interp_eval_batch",
+    "distrib_init",
+};
+
+__thread sim5stats* sim5stats_thread = NULL;
+
+sim5stats* sim5_stats_register()
+// creates statistics block for the calling thread and adds it to the list of blocks
+// (push to a lock-free list; the block is never freed, so that it outlives the thread)
+{
+    sim5stats* s = (sim5stats*)calloc(1, sizeof(sim5stats));
+    if (!s) {
+        // no counting is better than no computation
+        static sim5stats sim5stats_sink;
+        sim5stats_thread = &sim5stats_sink;
+        return sim5stats_thread;
+    }
+
+    sim5stats* head = __atomic_load_n(&sim5stats_list, __ATOMIC_ACQUIRE);
+    do {
+        s->next = head;
+    } while (!__atomic_compare_exchange_n(&sim5stats_list, &head, s, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    sim5stats_thread = s;
+    return s;
+}
+#endif
+//! \endcond
+
+
+int sim5_stats_enabled()
+//! Profiling status.
+//!
+//! @result Returns TRUE if the library has been compiled with SIM5_PROFILE, FALSE otherwise.
+{
+    #ifdef SIM5_PROFILE
+    return TRUE;
+    #else
+    return FALSE;
+    #endif
+}
+
+
+long sim5_stats_counter(int id)
+//! Value of an event counter.
+//! Gives the number of events summed over all threads.
+//!
+//! @param id counter identifier (SIM5_STAT_xxx)
+//!
+//! @result Number of events (zero if profiling is disabled).
+{
+    long n = 0;
+    sim5stats* s;
+    if ((id < 0) || (id >= SIM5_STAT_COUNT)) return 0;
+    for (s = __atomic_load_n(&sim5stats_list, __ATOMIC_ACQUIRE); s; s = s->next) {
+        n += __atomic_load_n(&s->count[id], __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+
+double sim5_stats_timer(int id, long* calls)
+//! Value of a timer.
+//! Gives the time spent in a timed routine summed over all threads.
+//!
+//! @param id timer identifier (SIM5_TIMER_xxx)
+//! @param calls number of timed calls (output, can be NULL)
+//!
+//! @result Total time [CPU cycles on x86, nanoseconds on other platforms].
+{
+    double t = 0.0;
+    long n = 0;
+    sim5stats* s;
+    if ((id >= 0) && (id < SIM5_TIMER_COUNT)) {
+        for (s = __atomic_load_n(&sim5stats_list, __ATOMIC_ACQUIRE); s; s = s->next) {
+            t += (double)__atomic_load_n(&s->timer_ticks[id], __ATOMIC_RELAXED);
+            n += __atomic_load_n(&s->timer_calls[id], __ATOMIC_RELAXED);
+        }
+    }
+    if (calls) *calls = n;
+    return t;
+}
+
+
+void sim5_stats_reset()
+//! Resets all counters and timers.
+//! The routine should not be called while other threads are running library routines,
+//! as their counts made during the reset may be lost.
+{
+    sim5stats* s;
+    int i;
+    for (s = __atomic_load_n(&sim5stats_list, __ATOMIC_ACQUIRE); s; s = s->next) {
+        for (i=0; i<SIM5_STAT_COUNT; i++) __atomic_store_n(&s->count[i], 0, __ATOMIC_RELAXED);
+        for (i=0; i<SIM5_TIMER_COUNT; i++) {
+            __atomic_store_n(&s->timer_calls[i], 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->timer_ticks[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+
+void sim5_stats_dump(FILE* file)
+//! Prints profiling statistics.
+//! Prints values of all counters and timers summed over all threads (including the threads
+//! that have already finished). Counters and timers that have not been hit are skipped.
+//!
+//! @param file output stream
+{
+    #ifndef SIM5_PROFILE
+    fprintf(file, "sim5 profiling is disabled (compile with SIM5_PROFILE)\n");
+    #else
+    int i;
+    long calls, threads = 0;
+    sim5stats* s;
+    for (s = __atomic_load_n(&sim5stats_list, __ATOMIC_ACQUIRE); s; s = s->next) threads++;
+    fprintf(file, "sim5 profiling statistics (%ld threads)\n", threads);
+
+    for (i=0; i<SIM5_STAT_COUNT; i++) {
+        long n = sim5_stats_counter(i);
+        if (n > 0) fprintf(file, "  %-40s %16ld\n", sim5stats_counter_names[i], n);
+    }
+
+    for (i=0; i<SIM5_TIMER_COUNT; i++) {
+        double t = sim5_stats_timer(i, &calls);
+        if (calls > 0) fprintf(file, "  %-40s %16ld calls %12.4e %s %10.1f %s/call\n",
+            sim5stats_timer_names[i], calls, t, SIM5_STATS_TICK_UNIT, t/(double)calls, SIM5_STATS_TICK_UNIT);
+    }
+    #endif
+}
+#endif
@@ -0,0 +1,115 @@
+//************************************************************************
+//    sim5profile.h - profiling counters and timers
+//************************************************************************
+
+
+#ifndef _SIM5PROFILE_H
+#define _SIM5PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// event counters
+#define SIM5_STAT_CONNECTION            0       // evaluations of Kerr connection
+#define SIM5_STAT_RAYTRACE_STEP         1       // raytrace() steps
+#define SIM5_STAT_RK4_FALLBACK          2       // raytrace() steps redone with RK4
+#define SIM5_STAT_ELLIPTIC_CALL         3       // calls of Carlson's integrals rf/rd/rc/rj
+#define SIM5_STAT_ELLIPTIC_ITER         4       // duplication iterations of Carlson's integrals
+#define SIM5_STAT_QUARTIC_RR            5       // R(r) root solves by resulting GEOD_TYPE
+#define SIM5_STAT_QUARTIC_RR_DBL        6
+#define SIM5_STAT_QUARTIC_RR_BH         7
+#define SIM5_STAT_QUARTIC_RC            8
+#define SIM5_STAT_QUARTIC_CC            9
+#define SIM5_STAT_QUARTIC_FAIL          10      // R(r) root solves with no valid solution
+#define SIM5_STAT_INTERP_SEARCH         11      // interpolation bisection searches
+#define SIM5_STAT_INTERP_DIRECT         12      // interpolation index lookups on uniform grids
+#define SIM5_STAT_COUNT                 13
+
+// timers
+#define SIM5_TIMER_RAYTRACE             0       // raytrace()
+#define SIM5_TIMER_RAYTRACE_RK4         1       // raytrace_rk4()
+#define SIM5_TIMER_QUARTIC              2       // R(r) root solve in geodesic_priv_R_roots()
+#define SIM5_TIMER_INTERP_BATCH         3       // sim5_interp_eval_batch()
+#define SIM5_TIMER_DISTRIB_INIT         4       // distrib_init()
+#define SIM5_TIMER_COUNT                5
+
+typedef struct sim5stats {
+    long count[SIM5_STAT_COUNT];            // event counts
+    long timer_calls[SIM5_TIMER_COUNT];     // number of timed sections
+    uint64_t timer_ticks[SIM5_TIMER_COUNT]; // total time spent in timed sections [ticks]
+    struct sim5stats* next;                 // next block in the list of all threads' blocks
+} sim5stats;
+
+
+#if defined(SIM5_PROFILE) && !defined(CUDA)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SIM5_STATS_TICK_UNIT "cycles"
+#else
+#define SIM5_STATS_TICK_UNIT "ns"
+#endif
+
+extern __thread sim5stats* sim5stats_thread;
+sim5stats* sim5_stats_register();
+
+//! \cond SKIP
+static inline sim5stats* sim5_stats_local()
+// statistics block of the calling thread (it is created on first use)
+{
+    return sim5stats_thread ? sim5stats_thread : sim5_stats_register();
+}
+
+static inline uint64_t sim5_stats_ticks()
+// time stamp for timers (TSC cycles on x86, monotonic clock in nanoseconds elsewhere)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+    #endif
+}
+
+// only the owner thread writes to its block, relaxed atomics keep concurrent reads well-defined
+// and compile to plain loads and stores
+#define sim5_stats_add(var, n) __atomic_store_n(&(var), __atomic_load_n(&(var), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+//! \endcond
+
+// counts an event
+#define SIM5_COUNT(id) sim5_stats_add(sim5_stats_local()->count[id], 1)
+
+// counts n events
+#define SIM5_COUNT_N(id, n) sim5_stats_add(sim5_stats_local()->count[id], (n))
+
+// starts a timer (a timer must be started and stopped within the same block of code)
+#define SIM5_TIMER_START(id) uint64_t sim5timer_##id = sim5_stats_ticks()
+
+// stops a timer and adds the elapsed time to its total
+#define SIM5_TIMER_STOP(id) do { \
+    sim5stats* sim5stats_ = sim5_stats_local(); \
+    sim5_stats_add(sim5stats_->timer_ticks[id], sim5_stats_ticks() - sim5timer_##id); \
+    sim5_stats_add(sim5stats_->timer_calls[id], 1); \
+} while (0)
+#else
+#define SIM5_COUNT(id) do {} while (0)
+#define SIM5_COUNT_N(id, n) do {} while (0)
+#define SIM5_TIMER_START(id) do {} while (0)
+#define SIM5_TIMER_STOP(id) do {} while (0)
+#endif
+
+
+#ifndef CUDA
+int  sim5_stats_enabled();
+long sim5_stats_counter(int id);
+double sim5_stats_timer(int id, long* calls);
+void sim5_stats_reset();
+void sim5_stats_dump(FILE* file);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -79,6 +79,429 @@ void blackbody(double T, double hardf, double cos_mu, double E[], double Iv[], i
 
 
 
+#ifndef CUDA
+//! \cond SKIP
+// Vectorizable approximation of exp(x) for -700<=x<=700 (arguments outside are clamped).
+// exp(x) is evaluated with Cody-Waite range reduction x = n*ln2 + r, |r|<=ln2/2, 
+// Taylor polynomial of degree 11 for exp(r) (truncation error < 1e-14) and 2^n 
+// constructed directly in the exponent bits. The function has no branches,
+// so that it can be inlined into vectorized loops.
+static inline double blackbody_exp(double x)
+{
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double shift  = 6755399441055744.0;       // 1.5*2^52
+    union { double d; int64_t i; } t, scale;
+
+    x = (x < 700.0) ? x : 700.0;
+    x = (x > -700.0) ? x : -700.0;
+
+    // exp(x) = 2^n * exp(r)
+    t.d = x*M_LOG2E + shift;
+    double n = t.d - shift;
+    double r = (x - n*ln2_hi) - n*ln2_lo;
+    double p = 1.0 + r*(1.0 + r*(1./2 + r*(1./6 + r*(1./24 + r*(1./120 + r*(1./720 + 
+               r*(1./5040 + r*(1./40320 + r*(1./362880 + r*(1./3628800 + r*(1./39916800)))))))))));
+    scale.i = (t.i - 0x4338000000000000LL + 1023) << 52;
+    return p*scale.d;
+}
+
+
+// Vectorizable approximation of 1/expm1(x) for x>=0.
+// expm1(x) for small x (x<ln2/2), where exp(x)-1 would lose precision, is evaluated 
+// from its own Taylor series. Both branches are computed and the result is selected 
+// without a jump. Arguments above 700 are clamped (the result is then ~1e-304, 
+// i.e. effectively zero). Relative error is below 1e-13 for all x>=0.
+static inline double blackbody_expm1_inv(double x)
+{
+    double em1_large = blackbody_exp(x) - 1.0;
+
+    // expm1(x) for small x
+    double em1_small = x*(1.0 + x*(1./2 + x*(1./6 + x*(1./24 + x*(1./120 + x*(1./720 + 
+                       x*(1./5040 + x*(1./40320 + x*(1./362880 + x*(1./3628800 + x*(1./39916800 +
+                       x*(1./479001600))))))))))));
+
+    return 1.0/((x < 0.34657359027997264) ? em1_small : em1_large);
+}
+
+
+// accumulation of one blackbody spectrum Iv[i] += A*E^3/expm1(B*E)
+static void blackbody_accumulate_kernel(int N, double A, double B, const double* restrict E, double* restrict Iv)
+{
+    int i;
+    for (i=0; i<N; i++) Iv[i] += A*E[i]*E[i]*E[i]*blackbody_expm1_inv(B*E[i]);
+}
+//! \endcond
+
+
+
+DEVICEFUNC
+void blackbody_accumulate(
+    int n, const double T[], const double g[], const double cos_mu[], const double hardf[], const double dOmega[],
+    const double E[], double Iv[], int N)
+//! Accumulated spectrum of many black-body emitters.
+//!
+//! Adds up Doppler-shifted specific intensities of `n` black-body emitters (e.g. image pixels 
+//! or disk surface elements) into one spectrum on the energy grid `E`. For each emitter `k`, 
+//! it adds the contribution
+//! \f[ I_\nu(E) \mathrel{+}= g^3\, I_\nu^{BB}(E/g; T, f, \mu)\, d\Omega \f]
+//! where \f$I_\nu^{BB}\f$ is the spectrum given by blackbody_Iv(), which is equivalent to a loop over 
+//! blackbody() calls, but it avoids temporary arrays and repeated evaluation of constants. 
+//! The function uses a vectorizable approximation of expm1() with relative error below 1e-13.
+//! Emitters with T<=0 are skipped.
+//!
+//! @param n number of emitters
+//! @param T array of temperatures [K]
+//! @param g array of redshift factors (ratio of observed to emitted photon energy)
+//! @param cos_mu array of cosines of emission directions with respect to the normal to the emission surface;
+//!               set cos_mu>=0 for limb-darkened emission and cos_mu<0 for isotropic emission
+//! @param hardf array of hardening factors (effective temperature corrections)
+//! @param dOmega array of solid angles (or other weights) of the emitters
+//! @param E array of energies (input) [keV]
+//! @param Iv array of specific intensities, to which the spectra are added (input/output) [erg cm^-2 s^-1 keV^-1 srad^-1 x units of dOmega]
+//! @param N dimension of the E[] and Iv[] arrays
+//!
+//! @result `Iv[]` array with the added contribution of all emitters
+{
+    int k;
+    const double BB1 = 2.0*planck_h/sqr(speed_of_light)*sqr4(kev2freq);
+    const double BB2 = (planck_h*kev2freq)/boltzmann_k;
+    for (k=0; k<n; k++) {
+        if (T[k] <= 0.0) continue;
+        // g^3 * (E/g)^3 = E^3, so the redshift only enters the exponent
+        double limbf = (cos_mu[k]>=0.0) ? 0.5+0.75*cos_mu[k] : 1.0;
+        double A = BB1 * limbf / sqr4(hardf[k]) * dOmega[k];
+        double B = BB2 / (hardf[k]*T[k]*g[k]);
+        blackbody_accumulate_kernel(N, A, B, E, Iv);
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------------
+// blackbody (tabulated)
+//-----------------------------------------------------------------------------------
+// Shape of the blackbody spectrum does not depend on temperature when expressed in 
+// x=E/kT; the spectrum redshifted by factor g and color-corrected by factor f is
+//   g^3 Iv(E/g; T, f) = limbf*BB1/f^4 * Theta^3 * phi(x),   x = E/Theta,  Theta = g*f*kT,
+// with phi(x)=x^3/expm1(x), and its integral over an energy bin is 
+//   limbf*BB1/f^4 * Theta^4 * [Phi(x2)-Phi(x1)],  Phi(x) = \int_0^x phi(x') dx'.
+// The routines below tabulate log(phi), log(Phi) and log(Phi_inf-Phi) on a grid in x, 
+// which is uniform in log(x) by octaves (BB_TABLE_K nodes per octave, uniform in x within
+// an octave), so that the node index is given directly by the exponent and mantissa bits of x. 
+// Values are interpolated by cubic Hermite polynomials using tabulated analytic derivatives 
+// and exponentiated by blackbody_exp(), so no libm transcendental function is called during
+// an evaluation.
+
+//! \cond SKIP
+#define BB_TABLE_K          7                                       // log2 of the number of nodes per octave
+#define BB_TABLE_EMIN       -20                                     // grid starts at x=2^EMIN
+#define BB_TABLE_EMAX       10                                      // grid ends at x=2^EMAX
+#define BB_TABLE_XMIN       0x1p-20                                 // 2^EMIN
+#define BB_TABLE_XMAX       0x1p+10                                 // 2^EMAX
+#define BB_TABLE_N          (((BB_TABLE_EMAX-BB_TABLE_EMIN)<<BB_TABLE_K)+1)
+#define BB_TABLE_XS         2.0                                     // switch between Phi and Phi_inf-Phi
+#define BB_TABLE_PHI_INF    6.49393940226682914909                  // pi^4/15
+
+typedef struct bb_table_node {
+    double lnf, dlnf;               // log(phi) and its derivative d/dx
+    double lnF, dlnF;               // log(Phi) and its derivative
+    double lnG, dlnG;               // log(Phi_inf-Phi) and its derivative
+} bb_table_node;
+
+typedef struct bb_table {
+    double error;                   // maximal relative interpolation error found at build time
+    bb_table_node node[BB_TABLE_N];
+} bb_table;
+
+static bb_table* blackbody_table_data = NULL;
+
+
+// exact log(phi(x))
+static double bb_exact_lnphi(double x)
+{
+    return (x < 30.0) ? 3.*log(x) - log(expm1(x)) : 3.*log(x) - x - log1p(-exp(-x));
+}
+
+
+// exact Phi(x) for x<=BB_TABLE_XS using series in Bernoulli numbers, 
+// \int_0^x t^3/(e^t-1) dt = \sum_n B_n/n! x^(n+3)/(n+3),  B_(2k)/(2k)! = (-1)^(k+1) 2 zeta(2k)/(2pi)^(2k)
+static double bb_exact_Phi(double x)
+{
+    int k, j;
+    double sum = x*x*x/3. - x*x*x*x/8.;
+    for (k=1; k<=30; k++) {
+        // zeta(2k) by direct summation up to J-1 plus Euler-Maclaurin formula for the tail
+        const double J = 100.;
+        double s = 2.*k, zeta = 0.0;
+        for (j=1; j<J; j++) zeta += pow(j, -s);
+        zeta += pow(J,1.-s)/(s-1.) + 0.5*pow(J,-s) + s/12.*pow(J,-s-1.) - s*(s+1.)*(s+2.)/720.*pow(J,-s-3.);
+        double b = ((k%2) ? +2. : -2.) * zeta / pow(2.*M_PI, s);
+        double term = b * pow(x, s+3.)/(s+3.);
+        sum += term;
+        if (fabs(term) < 1e-18*sum) break;
+    }
+    return sum;
+}
+
+
+// exact log(Phi_inf-Phi(x)) for x>=BB_TABLE_XS using series
+// \int_x^inf t^3/(e^t-1) dt = \sum_k e^(-kx) (x^3/k + 3x^2/k^2 + 6x/k^3 + 6/k^4)
+static double bb_exact_lnG(double x)
+{
+    int k;
+    double sum = 0.0;
+    for (k=1; k<=60; k++) {
+        double term = exp(-(k-1)*x) * (x*x*x/k + 3.*x*x/(k*k) + 6.*x/(k*k*k) + 6./(k*k*k*k));
+        sum += term;
+        if (term < 1e-18*sum) break;
+    }
+    return log(sum) - x;
+}
+
+
+// fills one node of the table
+static void bb_table_fill_node(bb_table_node* node, double x)
+{
+    double lnf = bb_exact_lnphi(x);
+    double phi = exp(lnf);
+    node->lnf  = lnf;
+    node->dlnf = 3./x - 1. - ((x < 700.) ? 1./expm1(x) : 0.0);
+    if (x <= BB_TABLE_XS) {
+        double F = bb_exact_Phi(x);
+        node->lnF  = log(F);
+        node->dlnF = phi/F;
+        node->lnG  = log(BB_TABLE_PHI_INF-F);
+        node->dlnG = -phi/(BB_TABLE_PHI_INF-F);
+    } else {
+        double lnG = bb_exact_lnG(x);
+        double G   = exp(lnG);
+        node->lnG  = lnG;
+        node->dlnG = -exp(lnf-lnG);
+        node->lnF  = log(BB_TABLE_PHI_INF-G);
+        node->dlnF = phi/(BB_TABLE_PHI_INF-G);
+    }
+}
+
+
+// gives the table node and the interpolation variable t for x in [2^EMIN, 2^EMAX)
+static inline const bb_table_node* bb_table_locate(const bb_table* table, double x, double* t, double* h)
+{
+    union { double d; int64_t i; } u, x0, dx;
+    u.d = x;
+    int64_t idx = (u.i >> (52-BB_TABLE_K)) - ((int64_t)(1023+BB_TABLE_EMIN) << BB_TABLE_K);
+    x0.i = (u.i >> (52-BB_TABLE_K)) << (52-BB_TABLE_K);                 // x of the node (truncated mantissa)
+    dx.i = (u.i & 0x7ff0000000000000LL) - ((int64_t)(BB_TABLE_K) << 52);  // node spacing 2^(e-K)
+    *h = dx.d;
+    *t = (x-x0.d)/dx.d;
+    return table->node + idx;
+}
+
+
+// cubic Hermite interpolation on unit interval
+static inline double bb_hermite(double y0, double d0, double y1, double d1, double h, double t)
+{
+    double t2 = t*t, t3 = t2*t;
+    return (2.*t3-3.*t2+1.)*y0 + (t3-2.*t2+t)*h*d0 + (-2.*t3+3.*t2)*y1 + (t3-t2)*h*d1;
+}
+
+
+// phi(x) from the table
+static inline double bb_table_phi(const bb_table* table, double x)
+{
+    if (x < BB_TABLE_XMIN) return x*x*(1. - 0.5*x + x*x/12.);
+    if (x >= BB_TABLE_XMAX) return 0.0;
+    double t, h;
+    const bb_table_node* n = bb_table_locate(table, x, &t, &h);
+    return blackbody_exp(bb_hermite(n[0].lnf, n[0].dlnf, n[1].lnf, n[1].dlnf, h, t));
+}
+
+
+// Phi(x) and Phi_inf-Phi(x) from the table
+static inline void bb_table_Phi(const bb_table* table, double x, double* F, double* G)
+{
+    if (x < BB_TABLE_XMIN) {
+        *F = x*x*x*(1./3. - x/8. + x*x/60.);
+        *G = BB_TABLE_PHI_INF - *F;
+        return;
+    }
+    if (x >= BB_TABLE_XMAX) {
+        *F = BB_TABLE_PHI_INF;
+        *G = 0.0;
+        return;
+    }
+    double t, h;
+    const bb_table_node* n = bb_table_locate(table, x, &t, &h);
+    if (x < BB_TABLE_XS) {
+        *F = blackbody_exp(bb_hermite(n[0].lnF, n[0].dlnF, n[1].lnF, n[1].dlnF, h, t));
+        *G = BB_TABLE_PHI_INF - *F;
+    } else {
+        *G = blackbody_exp(bb_hermite(n[0].lnG, n[0].dlnG, n[1].lnG, n[1].dlnG, h, t));
+        *F = BB_TABLE_PHI_INF - *G;
+    }
+}
+
+
+// integral of phi(x) over [x1,x2]
+static inline double bb_table_integral(const bb_table* table, double x1, double x2)
+{
+    // narrow bins: Simpson rule (avoids cancellation in the difference of cumulative values)
+    if (x2-x1 < 0.0625*((x1<1.0) ? x1 : 1.0)) {
+        return (x2-x1)/6. * (bb_table_phi(table,x1) + 4.*bb_table_phi(table,0.5*(x1+x2)) + bb_table_phi(table,x2));
+    }
+    double F1, G1, F2, G2;
+    bb_table_Phi(table, x1, &F1, &G1);
+    bb_table_Phi(table, x2, &F2, &G2);
+    return (x1 < BB_TABLE_XS) ? F2-F1 : G1-G2;
+}
+
+
+// builds the table (once per process); concurrent callers may build it in parallel, 
+// but only one copy is published and the others are discarded
+static const bb_table* blackbody_table()
+{
+    bb_table* table = __atomic_load_n(&blackbody_table_data, __ATOMIC_ACQUIRE);
+    if (table) return table;
+
+    int i;
+    bb_table* new_table = (bb_table*)malloc(sizeof(bb_table));
+    if (!new_table) {
+        fprintf(stderr, "ERR (blackbody_table): cannot allocate memory\n");
+        return NULL;
+    }
+
+    for (i=0; i<BB_TABLE_N; i++) {
+        int e = BB_TABLE_EMIN + (i >> BB_TABLE_K);
+        int m = i & ((1<<BB_TABLE_K)-1);
+        bb_table_fill_node(&new_table->node[i], ldexp(1.0 + (double)(m)/(1<<BB_TABLE_K), e));
+    }
+
+    // check interpolation error in the middle of each interval
+    new_table->error = 0.0;
+    for (i=0; i<BB_TABLE_N-1; i++) {
+        int e = BB_TABLE_EMIN + (i >> BB_TABLE_K);
+        int m = i & ((1<<BB_TABLE_K)-1);
+        double x = ldexp(1.0 + (double)(m+0.5)/(1<<BB_TABLE_K), e);
+        double F, G;
+        bb_table_node exact;
+        bb_table_fill_node(&exact, x);
+        bb_table_Phi(new_table, x, &F, &G);
+        double err_f = fabs(bb_table_phi(new_table, x)/exp(exact.lnf) - 1.0);
+        double err_F = (x < BB_TABLE_XS) ? fabs(F/exp(exact.lnF) - 1.0) : fabs(G/exp(exact.lnG) - 1.0);
+        if (exact.lnf < -690.) continue;    // skip values near underflow limit of blackbody_exp()
+        if (err_f > new_table->error) new_table->error = err_f;
+        if (err_F > new_table->error) new_table->error = err_F;
+    }
+
+    table = NULL;
+    if (!__atomic_compare_exchange_n(&blackbody_table_data, &table, new_table, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // other thread has been faster
+        free(new_table);
+        return table;
+    }
+    return new_table;
+}
+//! \endcond
+
+
+
+DEVICEFUNC
+double blackbody_table_error()
+//! Accuracy of tabulated black-body spectrum.
+//!
+//! Gives the maximal relative error of the interpolation of the tabulated black-body spectrum 
+//! and of its cumulative integral, as evaluated in the middle of each table interval (where the error
+//! of the Hermite interpolation is largest) when the table was built (~2e-10). It applies directly to 
+//! blackbody_table_Iv(); bin integrals of blackbody_table_bins() are differences of cumulative values, 
+//! or Simpson rule integrals for bins narrower than 1/16 of their lower edge (in units of kT, for 
+//! E<kT) or 1/16 kT (for E>kT), and their relative error stays below ~1e-8.
+//! The routine builds the table if it has not been built yet.
+//!
+//! @result maximal relative interpolation error
+{
+    const bb_table* table = blackbody_table();
+    return (table) ? table->error : 1.0;
+}
+
+
+
+DEVICEFUNC
+double blackbody_table_Iv(double T, double g, double hardf, double cos_mu, double E)
+//! Specific radiance of redshifted black-body radiation (tabulated).
+//!
+//! Gives specific intensity \f$g^3 I_\nu(E/g)\f$ of black-body radiation of temperature `T` 
+//! (see blackbody_Iv()) as seen by an observer, who measures photon energies shifted by factor `g`. 
+//! The spectrum is interpolated from a dimensionless Planck table that is built on the first call 
+//! (once per process, the call is thread-safe); the relative accuracy is given by blackbody_table_error().
+//!
+//! @param T temperature [K]
+//! @param g redshift factor (ratio of observed to emitted photon energy)
+//! @param hardf hardening factor (effective temperature correction)
+//! @param cos_mu cosine of emission direction with respect to the normal to the emission surface;
+//!               set cos_mu>=0 for limb-darkened emission and cos_mu<0 for isotropic emission
+//! @param E energy [keV]
+//!
+//! @result specific intensity in units [erg cm^-2 s^-1 keV^-1 srad^-1]
+{
+    if (T<=0.0) return 0.0;
+    const bb_table* table = blackbody_table();
+    if (!table) return g*g*g*blackbody_Iv(T, hardf, cos_mu, E/g);
+    double limbf = (cos_mu>=0.0) ? 0.5+0.75*cos_mu : 1.0;
+    double Theta = (boltzmann_k*hardf*T*g)/(planck_h*kev2freq);
+    double BB1   = 2.0*planck_h*sqr3(kev2freq)/sqr(speed_of_light)*(1./freq2kev);    // same as in blackbody_Iv()
+    return limbf*BB1/sqr4(hardf) * sqr3(Theta) * bb_table_phi(table, E/Theta);
+}
+
+
+
+DEVICEFUNC
+void blackbody_table_bins(double T, double g, double hardf, double cos_mu, double weight, double E[], double S[], int N)
+//! Redshifted black-body spectrum integrated over energy bins (tabulated).
+//!
+//! Adds the black-body spectrum \f$g^3 I_\nu(E/g)\f$ (see blackbody_table_Iv()) integrated over 
+//! energy bins to the array `S`, i.e. it adds 
+//! \f[ S_i \mathrel{+}= w \int_{E_i}^{E_{i+1}} g^3 I_\nu(E/g)\, dE \f]
+//! for each of the `N` bins given by `N+1` bin edges. Unlike sampling the spectrum at bin centers, 
+//! this conserves the flux in bins of any width. The integrals are given by tabulated
+//! cumulative Planck function (see blackbody_table_error() for accuracy).
+//!
+//! @param T temperature [K]
+//! @param g redshift factor (ratio of observed to emitted photon energy)
+//! @param hardf hardening factor (effective temperature correction)
+//! @param cos_mu cosine of emission direction with respect to the normal to the emission surface;
+//!               set cos_mu>=0 for limb-darkened emission and cos_mu<0 for isotropic emission
+//! @param weight weight of the contribution (e.g. solid angle of the emitting element)
+//! @param E array of N+1 bin edges (increasing) [keV]
+//! @param S array of N bin values, to which the spectrum is added (input/output) [erg cm^-2 s^-1 srad^-1 x units of weight]
+//! @param N number of bins
+//!
+//! @result `S[]` array with the added contribution of the spectrum
+{
+    if (T<=0.0) return;
+    const bb_table* table = blackbody_table();
+    if (!table) return;
+    int i;
+    double limbf = (cos_mu>=0.0) ? 0.5+0.75*cos_mu : 1.0;
+    double Theta = (boltzmann_k*hardf*T*g)/(planck_h*kev2freq);
+    double BB1   = 2.0*planck_h*sqr3(kev2freq)/sqr(speed_of_light)*(1./freq2kev);    // same as in blackbody_Iv()
+    double A     = weight*limbf*BB1/sqr4(hardf) * sqr4(Theta);
+    double Theta_1 = 1.0/Theta;
+    for (i=0; i<N; i++) S[i] += A*bb_table_integral(table, E[i]*Theta_1, E[i+1]*Theta_1);
+}
+
+
+#undef BB_TABLE_K
+#undef BB_TABLE_EMIN
+#undef BB_TABLE_EMAX
+#undef BB_TABLE_XMIN
+#undef BB_TABLE_XMAX
+#undef BB_TABLE_N
+#undef BB_TABLE_XS
+#undef BB_TABLE_PHI_INF
+#endif
+
+
+
 DEVICEFUNC INLINE
 double blackbody_photons(double T, double hardf, double cos_mu, double E)
 //! Specific photon intensity of black-body radiation.
@@ -114,6 +537,101 @@ double blackbody_photons_total(double T, double hardf)
 
 
 
+#ifndef CUDA
+//! \cond SKIP
+// Alias table for sampling of the index m in Planck photon energy sampler (see below).
+// P(m) = 1/(zeta(3) m^3); modes m=1..BB_ALIAS_M have their own bucket, the last bucket 
+// represents the tail m>BB_ALIAS_M (total probability ~4e-4), which is sampled by a loop.
+#define BB_ALIAS_M          31
+#define BB_ALIAS_N          (BB_ALIAS_M+1)
+#define BB_ZETA3            1.20205690315959428540
+
+typedef struct bb_alias_table {
+    double prob[BB_ALIAS_N];        // probability of keeping the bucket
+    int    alias[BB_ALIAS_N];       // alternative bucket
+    double tail;                    // sum of 1/m^3 for m>BB_ALIAS_M
+} bb_alias_table;
+
+static bb_alias_table* blackbody_alias_table_data = NULL;
+
+
+// builds the alias table (Vose's method) once per process
+static const bb_alias_table* blackbody_alias_table()
+{
+    bb_alias_table* table = __atomic_load_n(&blackbody_alias_table_data, __ATOMIC_ACQUIRE);
+    if (table) return table;
+
+    int i, m, n_small = 0, n_large = 0;
+    double p[BB_ALIAS_N];
+    int small[BB_ALIAS_N], large[BB_ALIAS_N];
+
+    bb_alias_table* new_table = (bb_alias_table*)malloc(sizeof(bb_alias_table));
+    if (!new_table) {
+        fprintf(stderr, "ERR (blackbody_alias_table): cannot allocate memory\n");
+        return NULL;
+    }
+
+    // bucket i holds mode m=i+1, the last bucket holds the tail
+    double sum = 0.0;
+    for (m=1; m<=BB_ALIAS_M; m++) sum += p[m-1] = 1.0/((double)m*m*m);
+    new_table->tail = BB_ZETA3 - sum;
+    p[BB_ALIAS_N-1] = new_table->tail;
+
+    for (i=0; i<BB_ALIAS_N; i++) {
+        p[i] *= (double)(BB_ALIAS_N)/BB_ZETA3;
+        if (p[i] < 1.0) small[n_small++] = i; else large[n_large++] = i;
+    }
+    while ((n_small > 0) && (n_large > 0)) {
+        int s = small[--n_small];
+        int l = large[--n_large];
+        new_table->prob[s]  = p[s];
+        new_table->alias[s] = l;
+        p[l] = (p[l]+p[s]) - 1.0;
+        if (p[l] < 1.0) small[n_small++] = l; else large[n_large++] = l;
+    }
+    while (n_large > 0) { i = large[--n_large]; new_table->prob[i] = 1.0; new_table->alias[i] = i; }
+    while (n_small > 0) { i = small[--n_small]; new_table->prob[i] = 1.0; new_table->alias[i] = i; }
+
+    table = NULL;
+    if (!__atomic_compare_exchange_n(&blackbody_alias_table_data, &table, new_table, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // other thread has been faster
+        free(new_table);
+        return table;
+    }
+    return new_table;
+}
+
+
+// samples the mode index m with probability 1/(zeta(3) m^3); 
+// returns 0 if the index falls in the tail (m>BB_ALIAS_M), which is then resolved by blackbody_alias_tail()
+static inline int blackbody_alias_sample(const bb_alias_table* table, double u)
+{
+    // one uniform number gives both the bucket and the coin
+    double x = u*BB_ALIAS_N;
+    int i = (int)x;
+    if (i >= BB_ALIAS_N) i = BB_ALIAS_N-1;
+    if (x-(double)(i) >= table->prob[i]) i = table->alias[i];
+    return (i < BB_ALIAS_N-1) ? i+1 : 0;
+}
+
+
+// samples the mode index m>BB_ALIAS_M of the tail (u is a fresh uniform number)
+static int blackbody_alias_tail(const bb_alias_table* table, double u)
+{
+    int m;
+    double target = u*table->tail;
+    double sum = 0.0;
+    for (m=BB_ALIAS_M+1; ; m++) {
+        sum += 1.0/((double)m*m*m);
+        if ((sum >= target) || (m > 1000000)) break;
+    }
+    return m;
+}
+//! \endcond
+#endif
+
+
+
 DEVICEFUNC
 double blackbody_photon_energy_random(double T)
 //! Draws a random photon energy that follows Planck distribution.
@@ -121,6 +639,10 @@ double blackbody_photon_energy_random(double T)
 //! Picks a random photon energy of black-body radiation according to
 //! Planck energy distribution at given temperature.
 //! For derivation see http://arxiv.org/abs/1307.3635, part 3.3.1.
+//! The photon energy is sampled as \f$E = kT\, \Gamma_3/m\f$, where \f$\Gamma_3=-\log(u_2 u_3 u_4)\f$ is a Gamma(3) 
+//! variate and the index `m` has probability \f$1/(\zeta(3)\, m^3)\f$. The index is picked in constant time
+//! using a precomputed alias table (built on the first call, once per process).
+//! Random numbers are taken from sim5urand().
 //!
 //! @param T temperature of the distribution [K] (including hardening factor)
 //!
@@ -131,13 +653,74 @@ double blackbody_photon_energy_random(double T)
     double u3 = sim5urand();
     double u4 = sim5urand();
     int m;
-    for (m=1; ; m++) {
+    #ifndef CUDA
+    const bb_alias_table* table = blackbody_alias_table();
+    if (table) {
+        m = blackbody_alias_sample(table, u1);
+        if (m == 0) m = blackbody_alias_tail(table, sim5urand());
+    } else
+    #endif
+    {
         double sum_j = 0.0;
-        for (int i=1; i<=m; i++) sum_j += 1.0/(double)(i*i*i);
-        if (1.202*u1 < sum_j) break;
+        for (m=1; ; m++) {
+            sum_j += 1.0/((double)m*m*m);
+            if (1.2020569031595942*u1 < sum_j) break;
+        }
     }
     return boltzmann_k*T * (-log(u2*u3*u4)) / (double)(m) * erg2kev;
 }
 
 
 
+#ifndef CUDA
+DEVICEFUNC
+void blackbody_photon_energy_random_n(sim5rng* rng, double T, double E[], long n)
+//! Draws random photon energies that follow Planck distribution.
+//!
+//! Fills the array `E` with `n` photon energies sampled from Planck energy distribution 
+//! at given temperature. This is the bulk version of blackbody_photon_energy_random(), 
+//! which avoids the per-call overhead and draws the uniform numbers in blocks from the given 
+//! random stream. With one stream per thread (see sim5rng_init()), the routine can be called 
+//! from multiple threads concurrently and the result does not depend on thread scheduling.
+//!
+//! @param rng random number stream
+//! @param T temperature of the distribution [K] (including hardening factor)
+//! @param E array of photon energies (output) [keV]
+//! @param n number of photons to draw
+//!
+//! @result `E[]` array with photon energies [keV]
+{
+    long i;
+    const bb_alias_table* table = blackbody_alias_table();
+    const double kT = boltzmann_k*T*erg2kev;
+    double u[4*64];
+    while (n > 0) {
+        long k = (n < 64) ? n : 64;
+        sim5rng_fill(rng, u, 4*k);
+        for (i=0; i<k; i++) {
+            int m;
+            if (table) {
+                m = blackbody_alias_sample(table, u[4*i]);
+                if (m == 0) m = blackbody_alias_tail(table, sim5rng_urand(rng));
+            } else {
+                double sum_j = 0.0;
+                for (m=1; ; m++) {
+                    sum_j += 1.0/((double)m*m*m);
+                    if (1.2020569031595942*u[4*i] < sum_j) break;
+                }
+            }
+            E[i] = kT * (-log(u[4*i+1]*u[4*i+2]*u[4*i+3])) / (double)(m);
+        }
+        E += k;
+        n -= k;
+    }
+}
+
+
+#undef BB_ALIAS_M
+#undef BB_ALIAS_N
+#undef BB_ZETA3
+#endif
+
+
+
@@ -31,9 +31,20 @@ static const stokes_params stokes_null = {0.0, 0.0, 0.0, 0.0, 0.0};
 
 DEVICEFUNC double blackbody_Iv(double T, double hardf, double cos_mu, double E);
 DEVICEFUNC void blackbody(double T, double hardf, double cos_mu, double E[], double Iv[], int en_bins);
+#ifndef CUDA
+DEVICEFUNC void blackbody_accumulate(
+    int n, const double T[], const double g[], const double cos_mu[], const double hardf[], const double dOmega[],
+    const double E[], double Iv[], int N);
+DEVICEFUNC double blackbody_table_error();
+DEVICEFUNC double blackbody_table_Iv(double T, double g, double hardf, double cos_mu, double E);
+DEVICEFUNC void blackbody_table_bins(double T, double g, double hardf, double cos_mu, double weight, double E[], double S[], int N);
+#endif
 DEVICEFUNC INLINE double blackbody_photons(double T, double hardf, double cos_mu, double E);
 DEVICEFUNC double blackbody_photons_total(double T, double hardf);
 DEVICEFUNC double blackbody_photon_energy_random(double T);
+#ifndef CUDA
+DEVICEFUNC void blackbody_photon_energy_random_n(sim5rng* rng, double T, double E[], long n);
+#endif
 
 #ifdef __cplusplus
 }
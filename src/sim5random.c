@@ -0,0 +1,354 @@
+//************************************************************************
+//    sim5random.c
+//************************************************************************
+
+//! \file sim5random.c
+//! Counter-based random number generator
+//!
+//! Implements the Philox4x32-10 generator (Salmon et al. 2011, "Parallel random numbers:
+//! as easy as 1, 2, 3"). Unlike a recursive generator, Philox has no internal state -
+//! its output is a bijective function of a 128-bit counter and a 64-bit key. The counter
+//! is split into a 64-bit stream number and a 64-bit block index, so any number from any
+//! stream can be obtained directly, streams can be handed to threads without locks or
+//! shared state, and a Monte Carlo run gives the same result regardless of the number
+//! of threads, provided that each photon draws from its own stream (see sim5rng_photon()).
+//! Each block produces four 32-bit words, i.e. two double precision numbers.
+//! The generator passes the BigCrush test battery.
+
+
+
+//! \cond SKIP
+#define PHILOX_M0   0xD2511F53U
+#define PHILOX_M1   0xCD9E8D57U
+#define PHILOX_W0   0x9E3779B9U
+#define PHILOX_W1   0xBB67AE85U
+
+// one Philox round: two 32x32->64 bit multiplications, xor with key and a word shuffle
+#define PHILOX_ROUND(c0,c1,c2,c3,k0,k1) {           \
+    uint64_t _p0 = (uint64_t)PHILOX_M0*(c0);        \
+    uint64_t _p1 = (uint64_t)PHILOX_M1*(c2);        \
+    c0 = (uint32_t)(_p1>>32) ^ (c1) ^ (k0);         \
+    c2 = (uint32_t)(_p0>>32) ^ (c3) ^ (k1);         \
+    c1 = (uint32_t)_p1;                             \
+    c3 = (uint32_t)_p0;                             \
+}
+
+#define PHILOX_BUMP(k0,k1) { k0 += PHILOX_W0; k1 += PHILOX_W1; }
+
+// ten rounds with key schedule (modifies counter words and key words in place)
+#define PHILOX_10ROUNDS(c0,c1,c2,c3,k0,k1) {        \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1); PHILOX_BUMP(k0,k1); \
+    PHILOX_ROUND(c0,c1,c2,c3,k0,k1);                     \
+}
+
+
+DEVICEFUNC INLINE static
+double philox_u64_to_double(uint64_t x)
+// maps the upper 52 bits of x to (k+0.5)*2^-52, i.e. into the open interval (0,1);
+// the conversion goes through the bit pattern of a double in [1,2), which vectorizes
+{
+    union { uint64_t i; double d; } u;
+    u.i = (x >> 12) | 0x3ff0000000000000ULL;
+    return (u.d - 1.0) + 0x1p-53;
+}
+
+
+DEVICEFUNC static
+void philox_blocks_u32(uint32_t k0, uint32_t k1, uint64_t block, uint32_t s0, uint32_t s1, uint32_t* out, size_t nblocks)
+// evaluates nblocks consecutive counters of one stream; the loop has no dependency
+// between iterations, so the compiler processes several counters at once in SIMD registers
+{
+    size_t i;
+    for (i=0; i<nblocks; i++) {
+        uint64_t b = block + i;
+        uint32_t c0 = (uint32_t)b, c1 = (uint32_t)(b>>32), c2 = s0, c3 = s1;
+        uint32_t kk0 = k0, kk1 = k1;
+        PHILOX_10ROUNDS(c0,c1,c2,c3,kk0,kk1);
+        out[4*i+0] = c0;
+        out[4*i+1] = c1;
+        out[4*i+2] = c2;
+        out[4*i+3] = c3;
+    }
+}
+
+
+DEVICEFUNC static
+void philox_blocks_double(uint32_t k0, uint32_t k1, uint64_t block, uint32_t s0, uint32_t s1, double* out, size_t nblocks)
+// as philox_blocks_u32(), but converts each pair of words to a double in (0,1)
+{
+    size_t i;
+    for (i=0; i<nblocks; i++) {
+        uint64_t b = block + i;
+        uint32_t c0 = (uint32_t)b, c1 = (uint32_t)(b>>32), c2 = s0, c3 = s1;
+        uint32_t kk0 = k0, kk1 = k1;
+        PHILOX_10ROUNDS(c0,c1,c2,c3,kk0,kk1);
+        out[2*i+0] = philox_u64_to_double((uint64_t)c0 | ((uint64_t)c1<<32));
+        out[2*i+1] = philox_u64_to_double((uint64_t)c2 | ((uint64_t)c3<<32));
+    }
+}
+
+
+DEVICEFUNC INLINE static
+uint64_t sim5rng_block(sim5rng* rng)
+// returns the block index of the counter
+{
+    return (uint64_t)rng->ctr[0] | ((uint64_t)rng->ctr[1]<<32);
+}
+
+
+DEVICEFUNC INLINE static
+void sim5rng_set_block(sim5rng* rng, uint64_t block)
+// sets the block index of the counter
+{
+    rng->ctr[0] = (uint32_t)block;
+    rng->ctr[1] = (uint32_t)(block>>32);
+}
+
+
+DEVICEFUNC INLINE static
+void sim5rng_refill(sim5rng* rng)
+// generates output for the current counter and advances the counter
+{
+    philox4x32(rng->ctr, rng->key, rng->buf);
+    sim5rng_set_block(rng, sim5rng_block(rng)+1);
+    rng->pos = 0;
+}
+//! \endcond
+
+
+
+DEVICEFUNC
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+//! Philox4x32-10 block function.
+//!
+//! Evaluates the Philox4x32 bijection with 10 rounds for a given counter and key.
+//! The result agrees with the reference implementation (Random123 library).
+//!
+//! @param ctr 128-bit counter (four 32-bit words)
+//! @param key 64-bit key (two 32-bit words)
+//! @param out output block (four 32-bit words)
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    PHILOX_10ROUNDS(c0,c1,c2,c3,k0,k1);
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+
+
+DEVICEFUNC
+void sim5rng_init(sim5rng* rng, uint64_t seed, uint64_t stream)
+//! Initializes a random number stream.
+//!
+//! Sets up the generator to produce the sequence of random numbers identified by
+//! the seed and the stream number. Streams with different numbers (or seeds) are statistically
+//! independent and each of them has a period of 2^65 double precision numbers.
+//! The structure is small and can be kept on the stack of each thread.
+//!
+//! @param rng pointer to generator structure
+//! @param seed seed (key) of the generator
+//! @param stream stream number
+{
+    rng->key[0] = (uint32_t)seed;
+    rng->key[1] = (uint32_t)(seed>>32);
+    rng->ctr[0] = 0;
+    rng->ctr[1] = 0;
+    rng->ctr[2] = (uint32_t)stream;
+    rng->ctr[3] = (uint32_t)(stream>>32);
+    rng->pos = 4;
+}
+
+
+
+DEVICEFUNC
+void sim5rng_photon(sim5rng* rng, uint64_t seed, uint64_t photon)
+//! Initializes a random number stream for a photon.
+//!
+//! Maps the photon index to a stream: photon with index i draws from stream number i.
+//! If a Monte Carlo code takes all random numbers needed to process a photon from its stream,
+//! the result does not depend on the number of threads or on the order in which
+//! the photons are processed. Other uses of the same seed should take stream numbers
+//! above the number of photons.
+//!
+//! @param rng pointer to generator structure
+//! @param seed seed (key) of the generator
+//! @param photon photon index
+{
+    sim5rng_init(rng, seed, photon);
+}
+
+
+
+DEVICEFUNC
+void sim5rng_seek(sim5rng* rng, uint64_t block)
+//! Moves within a stream.
+//!
+//! Positions the generator at the given block of its stream. Each block gives four 32-bit
+//! numbers or two double precision numbers, so after sim5rng_seek(rng,k) the next call
+//! of sim5rng_urand() returns the (2*k)-th number of the stream.
+//!
+//! @param rng pointer to generator structure
+//! @param block block index
+{
+    sim5rng_set_block(rng, block);
+    rng->pos = 4;
+}
+
+
+
+DEVICEFUNC
+uint32_t sim5rng_u32(sim5rng* rng)
+//! Random 32-bit integer.
+//!
+//! @param rng pointer to generator structure
+//!
+//! @result Uniformly distributed integer in the range [0, 2^32-1].
+{
+    if (rng->pos >= 4) sim5rng_refill(rng);
+    return rng->buf[rng->pos++];
+}
+
+
+
+DEVICEFUNC
+uint64_t sim5rng_u64(sim5rng* rng)
+//! Random 64-bit integer.
+//!
+//! The number is made of two aligned words of a block; if a single word has been
+//! taken by sim5rng_u32() before, the rest of its pair is skipped.
+//!
+//! @param rng pointer to generator structure
+//!
+//! @result Uniformly distributed integer in the range [0, 2^64-1].
+{
+    uint64_t x;
+    rng->pos += (rng->pos & 1);
+    if (rng->pos >= 4) sim5rng_refill(rng);
+    x = (uint64_t)rng->buf[rng->pos] | ((uint64_t)rng->buf[rng->pos+1]<<32);
+    rng->pos += 2;
+    return x;
+}
+
+
+
+DEVICEFUNC
+double sim5rng_urand(sim5rng* rng)
+//! Random number from uniform distribution.
+//!
+//! @param rng pointer to generator structure
+//!
+//! @result Uniformly distributed number in the open interval (0,1) with 52-bit resolution.
+{
+    return philox_u64_to_double(sim5rng_u64(rng));
+}
+
+
+
+DEVICEFUNC
+void sim5rng_fill_u32(sim5rng* rng, uint32_t* out, size_t n)
+//! Fills an array with random 32-bit integers.
+//!
+//! Gives the same numbers as n calls of sim5rng_u32(), but whole blocks are generated
+//! by a loop that is vectorized by the compiler.
+//!
+//! @param rng pointer to generator structure
+//! @param out output array
+//! @param n number of values
+{
+    size_t nb;
+    uint64_t block;
+
+    while ((rng->pos < 4) && (n > 0)) {
+        *(out++) = rng->buf[rng->pos++];
+        n--;
+    }
+
+    nb = n/4;
+    block = sim5rng_block(rng);
+    philox_blocks_u32(rng->key[0], rng->key[1], block, rng->ctr[2], rng->ctr[3], out, nb);
+    sim5rng_set_block(rng, block+nb);
+    out += 4*nb;
+    n -= 4*nb;
+
+    while (n-- > 0) *(out++) = sim5rng_u32(rng);
+}
+
+
+
+DEVICEFUNC
+void sim5rng_fill(sim5rng* rng, double* out, size_t n)
+//! Fills an array with random numbers from uniform distribution.
+//!
+//! Gives the same numbers as n calls of sim5rng_urand(), but whole blocks are generated
+//! by a loop that is vectorized by the compiler.
+//!
+//! @param rng pointer to generator structure
+//! @param out output array
+//! @param n number of values
+{
+    size_t nb;
+    uint64_t block;
+
+    rng->pos += (rng->pos & 1);
+    if ((rng->pos == 2) && (n > 0)) {
+        *(out++) = sim5rng_urand(rng);
+        n--;
+    }
+    if (n == 0) return;
+
+    nb = n/2;
+    block = sim5rng_block(rng);
+    philox_blocks_double(rng->key[0], rng->key[1], block, rng->ctr[2], rng->ctr[3], out, nb);
+    sim5rng_set_block(rng, block+nb);
+    rng->pos = 4;
+    out += 2*nb;
+    n -= 2*nb;
+
+    if (n > 0) *out = sim5rng_urand(rng);
+}
+
+
+
+DEVICEFUNC
+double sim5rng_urand_at(uint64_t seed, uint64_t stream, uint64_t index)
+//! Random number at a given position of a stream.
+//!
+//! Gives directly the index-th number of a stream without any state, i.e. the same
+//! number that the (index+1)-th call of sim5rng_urand() would give after sim5rng_init(rng,seed,stream).
+//!
+//! @param seed seed (key) of the generator
+//! @param stream stream number
+//! @param index position in the stream
+//!
+//! @result Uniformly distributed number in the open interval (0,1).
+{
+    uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed>>32)};
+    uint64_t block = index/2;
+    uint32_t ctr[4] = {(uint32_t)block, (uint32_t)(block>>32), (uint32_t)stream, (uint32_t)(stream>>32)};
+    uint32_t out[4];
+    philox4x32(ctr, key, out);
+    if (index & 1)
+        return philox_u64_to_double((uint64_t)out[2] | ((uint64_t)out[3]<<32));
+    else
+        return philox_u64_to_double((uint64_t)out[0] | ((uint64_t)out[1]<<32));
+}
+
+
+#undef PHILOX_M0
+#undef PHILOX_M1
+#undef PHILOX_W0
+#undef PHILOX_W1
+#undef PHILOX_ROUND
+#undef PHILOX_BUMP
+#undef PHILOX_10ROUNDS
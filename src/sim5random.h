@@ -0,0 +1,37 @@
+//************************************************************************
+//    sim5random.h - counter-based random number generator
+//************************************************************************
+
+
+#ifndef _SIM5RANDOM_H
+#define _SIM5RANDOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim5rng {
+    uint32_t key[2];        // key (seed)
+    uint32_t ctr[4];        // counter (ctr[0..1] = block index, ctr[2..3] = stream number)
+    uint32_t buf[4];        // output block for the current counter
+    int pos;                // number of words of buf that have been used
+} sim5rng;
+
+
+DEVICEFUNC void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+DEVICEFUNC void sim5rng_init(sim5rng* rng, uint64_t seed, uint64_t stream);
+DEVICEFUNC void sim5rng_photon(sim5rng* rng, uint64_t seed, uint64_t photon);
+DEVICEFUNC void sim5rng_seek(sim5rng* rng, uint64_t block);
+DEVICEFUNC uint32_t sim5rng_u32(sim5rng* rng);
+DEVICEFUNC uint64_t sim5rng_u64(sim5rng* rng);
+DEVICEFUNC double sim5rng_urand(sim5rng* rng);
+DEVICEFUNC void sim5rng_fill_u32(sim5rng* rng, uint32_t* out, size_t n);
+DEVICEFUNC void sim5rng_fill(sim5rng* rng, double* out, size_t n);
+DEVICEFUNC double sim5rng_urand_at(uint64_t seed, uint64_t stream, uint64_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
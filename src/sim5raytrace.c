@@ -61,16 +61,42 @@ void raytrace_prepare(double bh_spin, double x[4], double k[4], double presision
 //! @param precision_factor precision factor
 //! @param options additional options
 //! @param rtd raytracing data
+{
+    sim5spacetime st;
+    if ((options & RTOPT_FLAT) == RTOPT_FLAT) spacetime_flat(&st); else spacetime_kerr(bh_spin, &st);
+    raytrace_prepare_spacetime(&st, x, k, presision_factor, options, rtd);
+    rtd->bh_spin = bh_spin;
+}
+
+
+DEVICEFUNC
+void raytrace_prepare_spacetime(sim5spacetime* st, double x[4], double k[4], double presision_factor, int options, raytrace_data* rtd)
+//! Raytracing in a general spacetime.
+//! Prepares raytracing data for step-wise null-geodesic integration in a stationary axisymmetric 
+//! spacetime given by the descriptor `st` [see spacetime_kerr(), spacetime_flat() and spacetime_user()].
+//! The descriptor is copied into `rtd`, so it does not need to persist after the call.
+//! Otherwise the routine works the same way as raytrace_prepare().
+//!
+//! For user spacetimes the Carter's constant is not defined and raytrace_error() then 
+//! gives the relative error in terms of the motion constant k_t.
+//!
+//! @param st spacetime descriptor
+//! @param x initial position vector
+//! @param k initial direction vector (photon 4-momentum)
+//! @param precision_factor precision factor
+//! @param options additional options (RTOPT_FLAT is ignored here, the metric is given by `st`)
+//! @param rtd raytracing data
 {
     // read options
-    rtd->opt_gr  = !((options & RTOPT_FLAT) == RTOPT_FLAT);
+    rtd->spacetime = *st;
+    rtd->opt_gr  = (st->type != SPACETIME_FLAT);
     rtd->step_epsilon = sqrt(presision_factor)/10.;   // note: precision ~ (step_epsilon)^2; step_epsilon=0.1 gives reasonable precision ~1e-3
 
     // evaluate metric and connection 
     sim5metric m;
     double G[4][4][4];
-    rtd->opt_gr ? kerr_metric(bh_spin, x[1], x[2], &m) : flat_metric(x[1], x[2], &m);
-    rtd->opt_gr ? kerr_connection(bh_spin, x[1], x[2], G) : flat_connection(x[1], x[2], G);
+    spacetime_metric(&rtd->spacetime, x[1], x[2], &m);
+    spacetime_connection(&rtd->spacetime, x[1], x[2], G);
 
     // check that k.k=0
     double kk = dotprod(k, k, &m);
@@ -79,9 +105,9 @@ void raytrace_prepare(double bh_spin, double x[4], double k[4], double presision
     #endif
 
     // set motion constants
-    rtd->bh_spin = bh_spin;
+    rtd->bh_spin = st->a;
     rtd->E = k[0]*m.g00 + k[3]*m.g03;
-    rtd->Q  = photon_carter_const(k, &m);
+    rtd->Q = ((st->type == SPACETIME_KERR) || (st->type == SPACETIME_FLAT)) ? photon_carter_const(k, &m) : NAN;
 
     // set runtime varibles    
     rtd->pass = 0;
@@ -94,15 +120,17 @@ void raytrace_prepare(double bh_spin, double x[4], double k[4], double presision
 }
 
 //! \cond SKIP
-#ifdef CUDA
-DEVICEFUNC
-inline double k_deriv(int j, double _k[4], double G[4][4][4]) {
+// evaluate derivative of momentum from the geodesic equation; 
+// - this function does the same thing as Gamma() from sim5kerr.c (see there for info), 
+//   except this form takes out the summation over the upper index and uses the symmetry
+//   (also the inline form it runs ~2 times faster)
+DEVICEFUNC static inline
+double k_deriv(int j, double _k[4], double G[4][4][4]) {
     int a,b;
     double _dki = 0.0;
     for (a=0;a<4;a++) for (b=a;b<4;b++) _dki -= G[j][a][b]*_k[a]*_k[b];
     return _dki;
 }
-#endif
 
 
 DEVICEFUNC
@@ -139,23 +167,12 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
     double kk=0.0, kt = rtd->kt;
     float k_frac_error;
 
+    SIM5_TIMER_START(SIM5_TIMER_RAYTRACE);
+    SIM5_COUNT(SIM5_STAT_RAYTRACE_STEP);
+
     vect_copy(x, x_orig);
     vect_copy(k, k_orig);
 
-    #ifndef CUDA    
-    // evaluate derivative of momentum from the geodesic equation; 
-    // - this function does the same thing as Gamma() from sim5kerr.c (see there for info), 
-    //   except this form takes out the summation over the upper index and uses the symmetry
-    //   (also the inline form it runs ~2 times faster - no need for passing G to the function)
-    // - for CUDA it cannot be nested, so it is taked out of raytrace()
-    inline double k_deriv(int j, double _k[4]) {
-        int a,b;
-        double _dki = 0.0;
-        for (a=0;a<4;a++) for (b=a;b<4;b++) _dki -= G[j][a][b]*_k[a]*_k[b];
-        return _dki;
-    }
-    #endif
-
     // limit step into a reasonable iterval
     // smaller step must be used close to black hole (radial term: 0.05*x[1])
     // smaller step must be used close to polar axis (axial term: pow(1-x[2],0.5))
@@ -181,13 +198,8 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
     for (i=0;i<4;i++) k[i] += dk[i]*half_dl;
 
     // update metric and connection
-    if (rtd->opt_gr) {
-        kerr_metric(rtd->bh_spin, xp[1], xp[2], &m);
-        kerr_connection(rtd->bh_spin, xp[1], xp[2], G);
-    } else {
-        flat_metric(xp[1], xp[2], &m);
-        flat_connection(xp[1], xp[2], G);
-    }; 
+    spacetime_metric(&rtd->spacetime, xp[1], xp[2], &m);
+    spacetime_connection(&rtd->spacetime, xp[1], xp[2], G);
 
     // step 2: estimate new value for k and f (Dolence+09, Eq.14b)
     for (i=0;i<4;i++) kp[i] = k[i] + dk[i]*half_dl;
@@ -201,11 +213,7 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
         vect_copy(kp, kp_prev);
         for (i=0;i<4;i++) {
             // Dolence+09, Eq. (14c,d)
-            #ifdef CUDA
             kp[i] = k[i] + k_deriv(i,kp_prev,G)*half_dl;
-            #else
-            kp[i] = k[i] + k_deriv(i,kp_prev)*half_dl;
-            #endif
             k_frac_error += frac_error(kp[i],kp_prev[i]);
         }
 
@@ -221,8 +229,10 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
         vect_copy(x_orig, x);
         vect_copy(k_orig, k);
         DEVICEFUNC void raytrace_rk4(double x[4], double k[4], double dl, raytrace_data* rtd);
+        SIM5_COUNT(SIM5_STAT_RK4_FALLBACK);
         raytrace_rk4(x, k, dl, rtd);
         *step = dl;
+        SIM5_TIMER_STOP(SIM5_TIMER_RAYTRACE);
         return;
     }
 
@@ -230,11 +240,7 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
     for (i=0;i<4;i++) {
         x[i]  = xp[i];
         k[i]  = kp[i];
-        #ifdef CUDA
         dk[i] = k_deriv(i,kp,G);
-        #else
-        dk[i] = k_deriv(i,kp);
-        #endif
     }
 
     // assign motion constant for k in the current step
@@ -242,6 +248,8 @@ void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd)
 
     // assign the actual size of step taken
     *step = dl;
+
+    SIM5_TIMER_STOP(SIM5_TIMER_RAYTRACE);
 }
 
 
@@ -263,28 +271,29 @@ void raytrace_rk4(double x[4], double k[4], double dl, raytrace_data* rtd)
     //vect_copy(k, k_orig);
 
 
+    SIM5_TIMER_START(SIM5_TIMER_RAYTRACE_RK4);
     double kt0 = rtd->kt;
 
     // transform theta-component of coordinate vector to angle
     x[2] = acos(x[2]);
 
 	for (i=0; i<4; i++) xp[i] = x[i];
-    rtd->opt_gr ? kerr_connection(rtd->bh_spin, xp[1], cos(xp[2]), G) : flat_connection(xp[1], cos(xp[2]), G);
+    spacetime_connection(&rtd->spacetime, xp[1], cos(xp[2]), G);
 	for (i=0; i<4; i++) k1[i] = k[i];
     Gamma(G, k1, k1, dk1);
 
 	for (i=0; i<4; i++) xp[i] = x[i] + k1[i]*dl_2;
-    rtd->opt_gr ? kerr_connection(rtd->bh_spin, xp[1], cos(xp[2]), G) : flat_connection(xp[1], cos(xp[2]), G);
+    spacetime_connection(&rtd->spacetime, xp[1], cos(xp[2]), G);
 	for (i=0; i<4; i++) k2[i] = k[i] + dk1[i]*dl_2;
     Gamma(G, k2, k2, dk2);
 
 	for (i=0; i<4; i++) xp[i] = x[i] + k2[i]*dl_2;
-    rtd->opt_gr ? kerr_connection(rtd->bh_spin, xp[1], cos(xp[2]), G) : flat_connection(xp[1], cos(xp[2]), G);
+    spacetime_connection(&rtd->spacetime, xp[1], cos(xp[2]), G);
 	for (i=0; i<4; i++) k3[i] = k[i] + dk2[i]*dl_2;
     Gamma(G, k3, k3, dk3);
 
 	for (i=0; i<4; i++) xp[i] = x[i] + k3[i]*dl;
-    rtd->opt_gr ? kerr_connection(rtd->bh_spin, xp[1], cos(xp[2]), G) : flat_connection(xp[1], cos(xp[2]), G);
+    spacetime_connection(&rtd->spacetime, xp[1], cos(xp[2]), G);
 	for (i=0; i<4; i++) k4[i] = k[i] + dk3[i]*dl;
     Gamma(G, k4, k4, dk4);
 
@@ -298,14 +307,15 @@ void raytrace_rk4(double x[4], double k[4], double dl, raytrace_data* rtd)
 	x[2] = cos(x[2]);
 
     // update values for momentum and polarization vector derivatives
-    rtd->opt_gr ? kerr_connection(rtd->bh_spin, x[1], x[2], G) : flat_connection(x[1], x[2], G);
+    spacetime_connection(&rtd->spacetime, x[1], x[2], G);
     Gamma(G, k, k, rtd->dk);
 
 
-    kerr_metric(rtd->bh_spin, x[1], x[2], &m);
+    spacetime_metric(&rtd->spacetime, x[1], x[2], &m);
     double kt1 = k[0]*m.g00 + k[3]*m.g03;
 
     rtd->error = frac_error(kt1,kt0);
+    SIM5_TIMER_STOP(SIM5_TIMER_RAYTRACE_RK4);
     /*
 	if (rtd->error>1e-4) {
 	    fprintf(stderr,"WRN: RK4 rtd->error=%.3e (%d/%d) dl=%.2e ke=%.2e kp[1]=%.5e kp[2]=%.5e\n", rtd->error, rtd->pass, rtd->refines, dl, 0.0, k[1], k[2]);
@@ -328,7 +338,8 @@ DEVICEFUNC
 double raytrace_error(double x[4], double k[4], raytrace_data* rtd)
 //! Raytracing error.
 //! Gives relative error in raytracing in terms of relative difference of Carter's constant. 
-//! Useful for checking precission of integration.
+//! Useful for checking precission of integration. For user spacetimes, where Carter's constant
+//! is not available, the relative difference of the motion constant k_t is given instead.
 //! 
 //! @param x position vector
 //! @param k direction vector
@@ -338,7 +349,8 @@ double raytrace_error(double x[4], double k[4], raytrace_data* rtd)
 //! @result Relative error in raytracing.
 {
     sim5metric m;
-    rtd->opt_gr ? kerr_metric(rtd->bh_spin, x[1], x[2], &m) : flat_metric(x[1], x[2], &m);
+    spacetime_metric(&rtd->spacetime, x[1], x[2], &m);
+    if (isnan(rtd->Q)) return frac_error(rtd->E, k[0]*m.g00 + k[3]*m.g03);
     return frac_error(rtd->Q, photon_carter_const(k,&m));
 }
 
@@ -28,6 +28,7 @@ typedef struct raytrace_data {
     int opt_pol;            // polarization: 1=follow transport of f, 0=ignore f
     double step_epsilon;    // step size control factor (note: precision ~ step^2)
 
+    sim5spacetime spacetime;// spacetime in which the geodesic is integrated
     double bh_spin;         // black hole spin
     double E;               // initial motion constant - energy (k_t)
     double Q;               // initial motion constant - Carter constant
@@ -46,6 +47,9 @@ typedef struct raytrace_data {
 DEVICEFUNC
 void raytrace_prepare(double bh_spin, double x[4], double k[4], double presision_factor, int options, raytrace_data* rtd);
 
+DEVICEFUNC
+void raytrace_prepare_spacetime(sim5spacetime* st, double x[4], double k[4], double presision_factor, int options, raytrace_data* rtd);
+
 DEVICEFUNC
 void raytrace(double x[4], double k[4], double *step, raytrace_data* rtd);
 
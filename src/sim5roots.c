@@ -18,6 +18,16 @@
 #define MAX_STEPS  500
 //! \endcond
 
+//! \cond SKIP
+struct rtbis_plain { double (*fx)(double); };
+
+static double rtbis_plain_call(double x, void* ctx)
+{
+    return ((struct rtbis_plain*)ctx)->fx(x);
+}
+//! \endcond
+
+
 long rtbis(double x1, double x2, double xacc, double (*fx)(double), double* result)
 //! Root finding by bisection.
 //! Finds root of a function on an interval. Using bisection method, it finds the root of a 
@@ -30,12 +40,34 @@ long rtbis(double x1, double x2, double xacc, double (*fx)(double), double* resu
 //! @param fx function 
 //!
 //! @result Returns 1 if OK and the root position in `result`, 0 if error.
+{
+    struct rtbis_plain w = {fx};
+    return rtbis_ctx(x1, x2, xacc, rtbis_plain_call, &w, result);
+}
+
+
+
+long rtbis_ctx(double x1, double x2, double xacc, double (*fx)(double, void*), void* ctx, double* result)
+//! Root finding by bisection for function with context.
+//! Same as rtbis(), but the function receives a user pointer `ctx` with its parameters, 
+//! so no nested function is needed to pass them.
+//! Finds root of a function on an interval. Using bisection method, it finds the root of a 
+//! function `fx` that is known to lie between `x1` and `x2`. The root, returned as `result`, 
+//! will be refined until its accuracy is +/- xacc.
+//!
+//! @param x1 left boundary of the interval where the root is searched for
+//! @param x2 right boundary of the interval where the root is searched for
+//! @param xacc accuracy 
+//! @param fx function 
+//! @param ctx pointer that is passed to the function as its second argument
+//!
+//! @result Returns 1 if OK and the root position in `result`, 0 if error.
 {
 	double dx, f, fmid, xmid, rtb;
 	long j=0;
 
-	fmid = (*fx)(x2);
-	f    = (*fx)(x1);
+	fmid = (*fx)(x2, ctx);
+	f    = (*fx)(x1, ctx);
 	if ((f*fmid) >= 0.0) return(0);//error("rtbis: root is not bracketed");
 
 	if (f < 0.0) {
@@ -50,7 +82,7 @@ long rtbis(double x1, double x2, double xacc, double (*fx)(double), double* resu
 	for (j=0; j<MAX_STEPS; j++) {
 		dx = dx*0.5;
 		xmid = rtb+dx;
-		fmid = (*fx)(xmid);
+		fmid = (*fx)(xmid, ctx);
 		if (fmid <= 0.0) rtb = xmid;
 		if ((fabs(dx) < xacc) || (fmid == 0.0)) break;
 	}
@@ -17,6 +17,7 @@ extern "C" {
 #endif
 
 long rtbis(double x1, double x2, double xacc, double (*fx)(double), double* result);
+long rtbis_ctx(double x1, double x2, double xacc, double (*fx)(double, void*), void* ctx, double* result);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,65 @@
+//************************************************************************
+//    sim5unittests-diskmodel.c - disk model library for unit tests
+//------------------------------------------------------------------------
+//    A minimal external disk model that is loaded by test__diskmodel()
+//    in sim5unittests.c through the sim5disk.c interface. The model keeps
+//    its parameter in a static variable, so that the tests can check that
+//    several open copies of the library do not share their state.
+//************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DISKMODEL_FLUX                  -1
+#define DISKMODEL_SIGMA                 -2
+#define DISKMODEL_ELL                   -3
+#define DISKMODEL_VR                    -4
+#define DISKMODEL_H                     -5
+#define DISKMODEL_DHDR                  -6
+
+
+static double model_M = 0.0;
+static double model_a = 0.0;
+static double model_k = 1.0;
+
+
+int diskmodel_abi_version() { return 2; }
+
+int diskmodel_init(double M, double a, char* params)
+{
+    model_M = M;
+    model_a = a;
+    model_k = 1.0;
+    if (params && (strncmp(params, "k=", 2) == 0)) model_k = atof(params+2);
+    return (model_k > 0.0) ? 0 : -1;
+}
+
+void diskmodel_done() { model_k = 0.0; }
+char* diskmodel_name() { return "unittest"; }
+void diskmodel_params(FILE* output) { fprintf(output, "k=%e\n", model_k); }
+double diskmodel_r_min() { return 6.0; }
+double diskmodel_mdot() { return model_k; }
+double diskmodel_lumi() { return 0.1*model_k; }
+double diskmodel_flux(double R) { return model_k*pow(R, -3.); }
+double diskmodel_sigma(double R) { return model_k*pow(R, -0.5); }
+double diskmodel_ell(double R) { return sqrt(R); }
+double diskmodel_vr(double R) { return -0.01*model_k/R; }
+double diskmodel_h(double R) { return 0.1*R; }
+double diskmodel_dhdr(double R) { return 0.1; }
+double diskmodel_eval(double R, int quantity) { return model_k*quantity; }
+
+void diskmodel_eval_batch(const double* R, int n, int quantity, double* out)
+{
+    int i;
+    for (i=0; i<n; i++) switch (quantity) {
+        case DISKMODEL_FLUX:  out[i] = diskmodel_flux(R[i]); break;
+        case DISKMODEL_SIGMA: out[i] = diskmodel_sigma(R[i]); break;
+        case DISKMODEL_ELL:   out[i] = diskmodel_ell(R[i]); break;
+        case DISKMODEL_VR:    out[i] = diskmodel_vr(R[i]); break;
+        case DISKMODEL_H:     out[i] = diskmodel_h(R[i]); break;
+        case DISKMODEL_DHDR:  out[i] = diskmodel_dhdr(R[i]); break;
+        default:              out[i] = diskmodel_eval(R[i], quantity); break;
+    }
+}
@@ -2,17 +2,37 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
 #include "sim5lib.h"
+#include "sim5disk.h"
 
 
 #define EPS 1e-10
+#define rnd ((double)rand()/(double)RAND_MAX)
+
+
+// number of failed tests (the test program exits with non-zero status if any test fails)
+static int failures = 0;
 
 
 void test_raytrace();
 void test_geodesic_init_src();
 void test_ntdisk();
 void test__gauss_distribution();
+void test__distrib2d();
 void test__interpolation();
+void test__connection_ad();
+void test__disk_nt_setup();
+void test__philox_kat();
+void test__random_fill();
+void test__interp_batch();
+void test__interpnd();
+void test__steffen();
+void test__disktable();
+void test__diskmodel();
+void test__arena();
+void test__errors();
+void test__profile();
 
 
 int main() {
@@ -21,13 +41,28 @@ int main() {
 
     //test__interpolation();
     test__gauss_distribution();
+    test__distrib2d();
+
+    test__connection_ad();
+    test__disk_nt_setup();
+
+    test__philox_kat();
+    test__random_fill();
+    test__interp_batch();
+    test__interpnd();
+    test__steffen();
+    test__disktable();
+    test__diskmodel();
+    test__arena();
+    test__errors();
+    test__profile();
 
     //test_raytrace();
 
     //test_geodesic_init_src();
 
-
-    return 0;
+    if (failures) printf("%d test(s) FAILED\n", failures);
+    return failures ? 1 : 0;
 }
 
 
@@ -77,7 +112,7 @@ void test_raytrace() {
         tetrad_zamo(&m, &t);
 
         // set initial direction (k-vector)
-        double ang1 = rnd*M_2PI;
+        double ang1 = rnd*PI2;
         double ang2 = rnd*M_PI;
         double n[4];
         double k[4];
@@ -95,7 +130,7 @@ void test_raytrace() {
         f_loc[2] = n[3]*r1 - n[1]*r3;
         f_loc[3] = n[1]*r2 - n[2]*r1;
         on2bl(f_loc, f, &t);
-        vector_norm_to(f, &m, 1.0);
+        vector_norm_to(f, 1.0, &m);
 
         // checks of initial conditions
         kk1 = fabs(dotprod(k, k, &m));
@@ -107,16 +142,16 @@ void test_raytrace() {
 
         // get motion constants
         qq1 = photon_carter_const(k, &m);
-        wp1 = photon_wp_const(k, f, &m);
+        wp1 = polarization_constant(k, f, &m);
 
         // prepare raytrace
-        raytrace_prepare(bh_spin, x, k, NULL, 0.01, RTOPT_NONE, &rtd);
+        raytrace_prepare(bh_spin, x, k, 0.01, RTOPT_NONE, &rtd);
 
         // do raytrace
         t1 = clock();
         while (1) {
             double dl = 1e9; // use maximal step
-            raytrace(x, k, f, &dl, &rtd);
+            raytrace(x, k, &dl, &rtd);
             // stop condition:
             if ((x[1] < r_min) || (x[1] > r_max)) break;
             // also stop if relative error this step is too large
@@ -125,16 +160,16 @@ void test_raytrace() {
         t2 = clock();
 
         // get total relative error
-        double error = raytrace_error(x, k, f, &rtd);
+        double error = raytrace_error(x, k, &rtd);
 
         time += (t2-t1)/(double)CLOCKS_PER_SEC;
 
         // construct polarization vector at a new position
         kerr_metric(bh_spin, x[1], x[2], &m);
-        photon_polarization_vector(k, wp1, &m, f);
+        polarization_vector(k, wp1, &m, f);
 
         // do checks
-        wp2 = photon_wp_const(k, f, &m);
+        wp2 = polarization_constant(k, f, &m);
         qq2 = photon_carter_const(k, &m);
         kk2 = fabs(dotprod(k, k, &m));
         ff2 = fabs(dotprod(f, f, &m));
@@ -196,7 +231,7 @@ void test_geodesic_init_src()
 
             P = geodesic_find_midplane_crossing(&gd1, 0);
             if (isnan(P)) continue;
-            pa = (P > gd1.Rpa);
+            pa = (P > gd1.Rpc);
 
             // from the position parameter get radius of disk intersection
             r = geodesic_position_rad(&gd1, P);
@@ -214,11 +249,11 @@ void test_geodesic_init_src()
 
             raytrace_data rtd;
             double x[4];
-            vector(x, 0.0, r, 0.0, 0.0);
-            raytrace_prepare(a, x, k, NULL, 0.01, RTOPT_NONE, &rtd);
+            vector_set(x, 0.0, r, 0.0, 0.0);
+            raytrace_prepare(a, x, k, 0.01, RTOPT_NONE, &rtd);
             while (1) {
                 double dl = 1e9; // use maximal step
-                raytrace(x, k, NULL, &dl, &rtd);
+                raytrace(x, k, &dl, &rtd);
                 // stop condition:
                 if ((x[1] < r_bh(a)) || (x[1] > 1e9)) break;
                 // also stop if relative error this step is too large
@@ -307,10 +342,10 @@ void test__gauss_distribution()
     
     double gauss_pdf(double _x) { return exp(-sqr(_x)/2.)/sqrt(2*M_PI); }
 
-    distrib_init(&d, gauss_pdf, x_min, x_max);  
+    distrib_init(&d, gauss_pdf, x_min, x_max, 1000);  
     printf("# norm=%e\n", d.norm);
     
-    //for(i=0; i<d.icd.N; i++) printf("%e %e\n", d.icd.X[i], d.icd.Y[i]);
+    //for(i=0; i<d.cdf.N; i++) printf("%e %e\n", d.cdf.Y[i], d.cdf.X[i]);
     //return;
  
     double* pdf_x = (double*)malloc(N_pdf*sizeof(double));
@@ -332,5 +367,861 @@ void test__gauss_distribution()
     
     free(pdf_x);
     free(pdf_y);
+
+    // pass/fail checks of the guide-table sampling:
+    // moments and Kolmogorov-Smirnov distance of the samples to the exact CDF
+    const int N_ks = 100000;
+    double* xs = (double*)malloc(N_ks*sizeof(double));
+    double m1 = 0.0, m2 = 0.0, D = 0.0;
+    int failed = 0;
+    int cmp(const void* a, const void* b) { return (*(double*)a > *(double*)b) - (*(double*)a < *(double*)b); }
+
+    mt19937_init(4357);
+    distrib_hit_n(&d, xs, N_ks);
+    mt19937_init(4357);
+    for (i=0; i<N_ks; i++) if (distrib_hit(&d) != xs[i]) {
+        printf("gauss_distribution: distrib_hit_n differs from distrib_hit at %d\n", i);
+        failed++;
+        break;
+    }
+    for (i=0; i<N_ks; i++) { m1 += xs[i]; m2 += sqr(xs[i]); }
+    m1 /= N_ks; m2 = m2/N_ks - m1*m1;
+    qsort(xs, N_ks, sizeof(double), cmp);
+    for (i=0; i<N_ks; i++) {
+        double F = 0.5*(1.0+erf(xs[i]/sqrt(2.0)));
+        D = fmax(D, fmax(fabs(F-(double)(i)/N_ks), fabs(F-(double)(i+1)/N_ks)));
+    }
+    // 99.9% quantile of the KS distance is 1.95/sqrt(N), moments within ~5 standard errors
+    printf("gauss_distribution: mean=%.2e var=%.6f KS distance=%.3e (limit %.3e)\n", m1, m2, D, 1.95/sqrt(N_ks));
+    if ((fabs(m1) > 0.016) || (fabs(m2-1.0) > 0.025) || (D > 1.95/sqrt(N_ks))) failed++;
     distrib_done(&d);
+
+    // PDF with a zero-probability gap: no samples fall into the gap
+    double gap_pdf(double _x) { return (fabs(_x) < 1.0) ? 0.0 : exp(-fabs(_x)); }
+    distrib_init(&d, gap_pdf, -5.0, 5.0, 1000);
+    distrib_hit_n(&d, xs, N_ks);
+    for (i=0, m1=0.0; i<N_ks; i++) if (fabs(xs[i]) < 1.0-2.0*10.0/1000) m1++;
+    if (m1 > 0) {
+        printf("gauss_distribution: %.0f samples in zero-probability region\n", m1);
+        failed++;
+    }
+    distrib_done(&d);
+
+    free(xs);
+    printf("gauss_distribution: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__distrib2d()
+{
+    const int N = 200000;
+    const double rho = 0.6;
+    const double mx = 0.5, my = -0.3;
+    int i, failed = 0;
+    double *x = (double*)malloc(N*sizeof(double));
+    double *y = (double*)malloc(N*sizeof(double));
+    double sx = 0.0, sy = 0.0, sxx = 0.0, syy = 0.0, sxy = 0.0, D = 0.0;
+    sim5distrib2d d;
+
+    // correlated bivariate normal distribution with unit variances
+    double pdf(double _x, double _y) {
+        double a = _x-mx, b = _y-my;
+        return exp(-(a*a - 2.*rho*a*b + b*b)/(2.*(1.-rho*rho)));
+    }
+    int cmp(const void* a, const void* b) { return (*(double*)a > *(double*)b) - (*(double*)a < *(double*)b); }
+
+    distrib2d_init(&d, pdf, mx-6.0, mx+6.0, 200, my-6.0, my+6.0, 200);
+    mt19937_init(4357);
+    distrib2d_hit_n(&d, x, y, N);
+    distrib2d_done(&d);
+
+    for (i=0; i<N; i++) {
+        sx += x[i]; sy += y[i];
+        sxx += sqr(x[i]); syy += sqr(y[i]); sxy += x[i]*y[i];
+    }
+    sx /= N; sy /= N;
+    sxx = sxx/N - sx*sx; syy = syy/N - sy*sy; sxy = sxy/N - sx*sy;
+    double r = sxy/sqrt(sxx*syy);
+
+    // marginal distribution of y (the conditional part of the sampling) against exact CDF
+    qsort(y, N, sizeof(double), cmp);
+    for (i=0; i<N; i++) {
+        double F = 0.5*(1.0+erf((y[i]-my)/sqrt(2.0)));
+        D = fmax(D, fmax(fabs(F-(double)(i)/N), fabs(F-(double)(i+1)/N)));
+    }
+
+    // tolerances are about 5 standard errors (1.95/sqrt(N) is the 99.9% quantile of KS distance)
+    printf("distrib2d: mean=(%.4f,%.4f) var=(%.4f,%.4f) corr=%.4f KS(y)=%.3e\n", sx, sy, sxx, syy, r, D);
+    if ((fabs(sx-mx) > 0.012) || (fabs(sy-my) > 0.012)) failed++;
+    if ((fabs(sxx-1.0) > 0.02) || (fabs(syy-1.0) > 0.02)) failed++;
+    if (fabs(r-rho) > 0.008) failed++;
+    if (D > 1.95/sqrt(N)) failed++;
+
+    free(x);
+    free(y);
+    printf("distrib2d: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+void test__connection_ad()
+{
+    const int N = 1000000;
+    int i, j, k, l;
+    double G1[4][4][4], G2[4][4][4];
+    double a = 0.9;
+    double max_err = 0.0;
+    clock_t t1, t2;
+    double time_kerr, time_ad;
+
+    // Kerr metric written in dual numbers
+    void kerr_metric_ad(sim5dual r, sim5dual m, sim5metric_dual* g, void* params) {
+        double a  = *(double*)params;
+        sim5dual r2 = dual_sqr(r);
+        sim5dual m2 = dual_sqr(m);
+        sim5dual S  = dual_add(r2, dual_mulc(m2, a*a));
+        sim5dual D  = dual_addc(dual_sub(r2, dual_mulc(r, 2.)), a*a);
+        sim5dual s2S = dual_div(dual_addc(dual_mulc(m2,-1.), 1.), S);
+        g->g00 = dual_addc(dual_mulc(dual_div(r, S), 2.), -1.);
+        g->g11 = dual_div(S, D);
+        g->g22 = S;
+        g->g33 = dual_mul(dual_add(dual_sqr(dual_addc(r2, a*a)), dual_mulc(dual_mul(D, dual_mul(s2S,S)), -a*a)), s2S);
+        g->g03 = dual_mulc(dual_mul(r, s2S), -2.*a);
+    }
+
+    // accuracy
+    for (i=0; i<10000; i++) {
+        double r = r_bh(a)*1.05 + 100.*rnd;
+        double m = 1.98*rnd - 0.99;
+        kerr_connection(a, r, m, G1);
+        connection_ad(kerr_metric_ad, &a, r, m, G2);
+        for (j=0;j<4;j++) for (k=0;k<4;k++) for (l=0;l<4;l++) {
+            double err = fabs(G1[j][k][l]-G2[j][k][l])/(fabs(G1[j][k][l])+1e-10);
+            if (err > max_err) max_err = err;
+        }
+    }
+    printf("connection_ad: max relative difference to kerr_connection: %.3e\n", max_err);
+    if (max_err > 1e-8) {
+        printf("connection_ad: FAILED (tolerance 1e-8)\n");
+        failures++;
+    }
+
+    // speed
+    double sum = 0.0;
+    t1 = clock();
+    for (i=0; i<N; i++) {
+        kerr_connection(a, 2.0+(double)(i%1000)*0.1, 0.5, G1);
+        sum += G1[1][0][0];
+    }
+    t2 = clock();
+    time_kerr = (t2-t1)/(double)CLOCKS_PER_SEC;
+
+    t1 = clock();
+    for (i=0; i<N; i++) {
+        connection_ad(kerr_metric_ad, &a, 2.0+(double)(i%1000)*0.1, 0.5, G2);
+        sum += G2[1][0][0];
+    }
+    t2 = clock();
+    time_ad = (t2-t1)/(double)CLOCKS_PER_SEC;
+
+    printf("connection_ad: kerr_connection %.1f ns/call, connection_ad %.1f ns/call (ratio %.2f) [%e]\n", 
+        time_kerr/N*1e9, time_ad/N*1e9, time_ad/time_kerr, sum);
+}
+
+
+
+void test__disk_nt_setup()
+{
+    const int N = 100000;
+    const int N_ref = 20;
+    int i;
+    double L0 = 0.3;
+    sim5disknt d;
+    clock_t t1, t2;
+    double time_table, time_ref, time_setup, sum = 0.0;
+    double mdot_ref[N_ref], max_err = 0.0;
+
+    // reference: mdot found by bisection on directly integrated luminosity
+    double fce(double xmdot) {
+        d.mdot = xmdot;
+        return L0-disknt_lumi_integrate(&d);
+    }
+
+    t1 = clock();
+    disknt_lumi_per_mdot(0.0);
+    t2 = clock();
+    time_table = (t2-t1)/(double)CLOCKS_PER_SEC;
+
+    t1 = clock();
+    for (i=0; i<N_ref; i++) {
+        double mdot;
+        disknt_setup(&d, 10.0, -0.99+1.98*i/N_ref, 0.1, 0.1, 0);
+        rtbis(0.0, 100.0, 1e-6, fce, &mdot);
+        sum += mdot;
+        mdot_ref[i] = mdot;
+    }
+    t2 = clock();
+    time_ref = (t2-t1)/(double)CLOCKS_PER_SEC/N_ref;
+
+    // accuracy: mdot from the table against the root search
+    for (i=0; i<N_ref; i++) {
+        disknt_setup(&d, 10.0, -0.99+1.98*i/N_ref, L0, 0.1, DISK_NT_OPTION_LUMINOSITY);
+        max_err = fmax(max_err, fabs(d.mdot/mdot_ref[i]-1.0));
+    }
+
+    t1 = clock();
+    for (i=0; i<N; i++) {
+        disknt_setup(&d, 10.0, -0.99+1.98*i/N, L0, 0.1, DISK_NT_OPTION_LUMINOSITY);
+        sum += d.mdot;
+    }
+    t2 = clock();
+    time_setup = (t2-t1)/(double)CLOCKS_PER_SEC/N;
+
+    disknt_setup(&d, 10.0, 0.9, L0, 0.1, DISK_NT_OPTION_LUMINOSITY);
+    printf("disk_nt_setup: L=%.6f for L0=%.6f (table built in %.3f s)\n", disknt_lumi_integrate(&d), L0, time_table);
+    printf("disk_nt_setup: root search %.3e s/call, tabulated %.3e s/call (speedup %.0fx) [%e]\n",
+        time_ref, time_setup, time_ref/time_setup, sum);
+    printf("disk_nt_setup: max relative difference of mdot to root search: %.3e\n", max_err);
+    if (max_err > 1e-4) {
+        printf("disk_nt_setup: FAILED (tolerance 1e-4)\n");
+        failures++;
+    }
+}
+
+
+
+void test__philox_kat()
+{
+    // known-answer vectors of Philox4x32-10 (Random123, kat_vectors)
+    const uint32_t kat_ctr[3][4] = {
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000},
+        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+        {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+    };
+    const uint32_t kat_key[3][2] = {
+        {0x00000000, 0x00000000},
+        {0xffffffff, 0xffffffff},
+        {0xa4093822, 0x299f31d0},
+    };
+    const uint32_t kat_out[3][4] = {
+        {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+        {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+        {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1},
+    };
+    const int N = 1001;
+    int i, j, failed = 0;
+    uint32_t out[4];
+    double u[N], v[N];
+    uint32_t w[N];
+    sim5rng rng;
+
+    for (i=0; i<3; i++) {
+        philox4x32(kat_ctr[i], kat_key[i], out);
+        for (j=0; j<4; j++) if (out[j] != kat_out[i][j]) {
+            printf("philox_kat: vector %d word %d: %08x (expected %08x)\n", i, j, out[j], kat_out[i][j]);
+            failed++;
+        }
+    }
+
+    // reference: scalar draws
+    sim5rng_init(&rng, 12345, 7);
+    for (i=0; i<N; i++) u[i] = sim5rng_urand(&rng);
+
+    // bulk fill, also when started in the middle of a block
+    for (j=0; j<4; j++) {
+        sim5rng_init(&rng, 12345, 7);
+        for (i=0; i<j; i++) v[i] = sim5rng_urand(&rng);
+        sim5rng_fill(&rng, v+j, N-j);
+        for (i=0; i<N; i++) if (v[i] != u[i]) {
+            printf("philox_kat: sim5rng_fill (offset %d) differs at %d\n", j, i);
+            failed++;
+            break;
+        }
+    }
+
+    // seek and stateless access
+    for (i=0; i<N-1; i+=2) {
+        sim5rng_init(&rng, 12345, 7);
+        sim5rng_seek(&rng, i/2);
+        if ((sim5rng_urand(&rng) != u[i]) || (sim5rng_urand(&rng) != u[i+1]) || (sim5rng_urand_at(12345, 7, i) != u[i])) {
+            printf("philox_kat: sim5rng_seek/sim5rng_urand_at differs at %d\n", i);
+            failed++;
+            break;
+        }
+    }
+
+    // 32-bit words
+    sim5rng_init(&rng, 12345, 7);
+    sim5rng_fill_u32(&rng, w, N);
+    sim5rng_init(&rng, 12345, 7);
+    for (i=0; i<N; i++) if (sim5rng_u32(&rng) != w[i]) {
+        printf("philox_kat: sim5rng_fill_u32 differs at %d\n", i);
+        failed++;
+        break;
+    }
+
+    printf("philox_kat: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__random_fill()
+{
+    const int N = 1001;
+    const int M = 1000001;
+    int i, j, failed = 0;
+    double u[N], v[N];
+    unsigned long long r[N], q[N];
+    double* x = (double*)malloc(3*M*sizeof(double));
+    double m1, m2, m3;
+
+    // bulk uniform numbers against scalar draws (also when started in the middle of the state)
+    for (j=0; j<2; j++) {
+        mt19937_init(4357);
+        for (i=0; i<j; i++) u[i] = v[i] = sim5urand();
+        for (i=j; i<N; i++) u[i] = sim5urand();
+        mt19937_init(4357);
+        for (i=0; i<j; i++) sim5urand();
+        sim5_urand_fill(v+j, N-j);
+        for (i=0; i<N; i++) if (v[i] != u[i]) {
+            printf("random_fill: sim5_urand_fill (offset %d) differs at %d\n", j, i);
+            failed++;
+            break;
+        }
+    }
+
+    // raw 64-bit words
+    mt19937_init(4357);
+    for (i=0; i<N; i++) r[i] = mt19937_int64();
+    mt19937_init(4357);
+    mt19937_fill_int64(q, N);
+    for (i=0; i<N; i++) if (q[i] != r[i]) {
+        printf("random_fill: mt19937_fill_int64 differs at %d\n", i);
+        failed++;
+        break;
+    }
+
+    // moments (tolerances are about 5 standard errors for M samples)
+    mt19937_init(4357);
+    sim5_nrand_fill(x, M);
+    for (i=0, m1=m2=0.0; i<M; i++) { m1 += x[i]; m2 += x[i]*x[i]; }
+    m1 /= M; m2 = m2/M - m1*m1;
+    printf("random_fill: normal mean=%.2e var=%.6f\n", m1, m2);
+    if ((fabs(m1) > 0.005) || (fabs(m2-1.0) > 0.01)) failed++;
+
+    sim5_erand_fill(x, M);
+    for (i=0, m1=m2=0.0; i<M; i++) { m1 += x[i]; m2 += x[i]*x[i]; if (!(x[i] > 0.0)) failed++; }
+    m1 /= M; m2 = m2/M - m1*m1;
+    printf("random_fill: exponential mean=%.6f var=%.6f\n", m1, m2);
+    if ((fabs(m1-1.0) > 0.005) || (fabs(m2-1.0) > 0.02)) failed++;
+
+    sim5_isotropic_fill(x, M);
+    for (i=0, m1=m2=m3=0.0; i<M; i++) {
+        if (fabs(sqr(x[3*i])+sqr(x[3*i+1])+sqr(x[3*i+2]) - 1.0) > 1e-12) failed++;
+        m1 += x[3*i+2];
+        m2 += x[3*i+0]*x[3*i+1];
+        m3 += sqr(x[3*i+2]);
+    }
+    m1 /= M; m2 /= M; m3 /= M;
+    printf("random_fill: isotropic <z>=%.2e <xy>=%.2e <z^2>=%.6f\n", m1, m2, m3);
+    if ((fabs(m1) > 0.003) || (fabs(m2) > 0.002) || (fabs(m3-1./3.) > 0.002)) failed++;
+
+    free(x);
+    printf("random_fill: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+void test__interp_batch()
+{
+    const int N = 50;
+    const int M = 1000;
+    const int types[] = {INTERP_TYPE_LINLIN, INTERP_TYPE_LINLOG, INTERP_TYPE_LOGLIN, INTERP_TYPE_LOGLOG, INTERP_TYPE_SPLINE, INTERP_TYPE_STEFFEN};
+    const char* grid_names[] = {"irregular", "uniform", "log-uniform"};
+    int i, k, g, t, failed = 0;
+    double x[N], y[N], xs[M], ys[M], yb[M];
+
+    for (g=0; g<3; g++) {
+        // data grids
+        for (i=0; i<N; i++) {
+            switch (g) {
+                case 0: x[i] = 1.0 + 10.0*sqr((double)(i)/(N-1)); break;
+                case 1: x[i] = 1.0 + 10.0*(double)(i)/(N-1); break;
+                case 2: x[i] = exp(log(11.0)*(double)(i)/(N-1)); break;
+            }
+            y[i] = 2.0 + sin(x[i]);
+        }
+
+        for (t=0; t<(int)(sizeof(types)/sizeof(types[0])); t++) {
+            sim5interp in;
+            sim5_interp_init(&in, x, y, N, INTERP_DATA_REF, types[t], (types[t] == INTERP_TYPE_SPLINE) ? 0 : INTERP_OPT_CAN_EXTRAPOLATE);
+
+            for (k=0; k<2; k++) {
+                // sorted (merge walk) and unsorted (direct index or bisection) input, 
+                // including points at the nodes and outside of the grid
+                for (i=0; i<M; i++) {
+                    if (k == 0) xs[i] = 0.9 + 10.2*(double)(i)/(M-1); else xs[i] = 0.9 + 10.2*rnd;
+                }
+                xs[M/2] = x[N/2];
+                if (k == 0) xs[M-1] = x[N-1];
+                for (i=0; i<M; i++) ys[i] = sim5_interp_eval(&in, xs[i]);
+                sim5_interp_eval_batch(&in, xs, M, yb);
+                for (i=0; i<M; i++) if (!((yb[i] == ys[i]) || (isnan(yb[i]) && isnan(ys[i])))) {
+                    printf("interp_batch: %s grid, type %d, %s: differs at x=%.6e (%.16e vs %.16e)\n",
+                        grid_names[g], types[t], k ? "unsorted" : "sorted", xs[i], yb[i], ys[i]);
+                    failed++;
+                    break;
+                }
+            }
+
+            sim5_interp_done(&in);
+        }
+    }
+
+    printf("interp_batch: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__interpnd()
+{
+    const int M = 1000;
+    int i, k, failed = 0;
+    double ax0[5] = {0.0, 0.5, 1.5, 2.0, 4.0};      // irregular
+    double ax1[4] = {-1.0, 0.0, 1.0, 2.0};          // uniform
+    double ax2[3] = {1.0, 10.0, 100.0};             // log-uniform (linear interpolation in x)
+    double* axes[3] = {ax0, ax1, ax2};
+    long n[3] = {5, 4, 3};
+    double data[5*4*3];
+    double xs[3*M], yb[M];
+    double max_err = 0.0;
+    sim5interpnd ip;
+
+    // multilinear function is reproduced exactly by multilinear interpolation (also when extrapolated)
+    double f(const double x[]) { return 1.0 + 2.0*x[0] - 3.0*x[1] + 0.1*x[2] + 0.5*x[0]*x[1] - 0.01*x[1]*x[2] + 0.02*x[0]*x[1]*x[2]; }
+
+    for (i=0; i<5*4*3; i++) {
+        double x[3] = {ax0[i/12], ax1[(i/3)%4], ax2[i%3]};
+        data[i] = f(x);
+    }
+
+    for (k=0; k<2; k++) {
+        if (sim5_interpnd_init(&ip, 3, n, axes, data, NULL, 0, k ? INTERP_OPT_CAN_EXTRAPOLATE : 0) != 0) {
+            printf("interpnd: FAILED (init)\n");
+            failures++;
+            return;
+        }
+
+        // inside the grid, including the nodes and the upper boundary
+        for (i=0; i<M; i++) {
+            double* x = xs+3*i;
+            x[0] = 4.0*rnd;
+            x[1] = -1.0 + 3.0*rnd;
+            x[2] = 1.0 + 99.0*rnd;
+            if (i == 0) { x[0] = 4.0; x[1] = 2.0; x[2] = 100.0; }
+            if (i == 1) { x[0] = 1.5; x[1] = 0.0; x[2] = 10.0; }
+            max_err = fmax(max_err, fabs(sim5_interpnd_eval(&ip, x) - f(x)));
+        }
+        sim5_interpnd_eval_batch(&ip, xs, M, yb);
+        for (i=0; i<M; i++) if (yb[i] != sim5_interpnd_eval(&ip, xs+3*i)) {
+            printf("interpnd: batch evaluation differs at point %d\n", i);
+            failed++;
+            break;
+        }
+
+        // outside of the grid: extrapolated or moved to the boundary
+        {
+            double x[3] = {-0.5, 2.5, 150.0};
+            double xb[3] = {0.0, 2.0, 100.0};
+            double y = sim5_interpnd_eval(&ip, x);
+            double y_expected = k ? f(x) : f(xb);
+            if (fabs(y - y_expected) > 1e-10*fabs(y_expected)) {
+                printf("interpnd: %s outside of the grid gives %.10e (expected %.10e)\n", k ? "extrapolation" : "clamping", y, y_expected);
+                failed++;
+            }
+        }
+
+        sim5_interpnd_done(&ip);
+    }
+
+    printf("interpnd: max error on multilinear function %.3e\n", max_err);
+    if (max_err > 1e-12) failed++;
+
+    // invalid grids are rejected
+    {
+        double bad0[5] = {0.0, 0.5, 0.5, 2.0, 4.0};    // not strictly increasing
+        double bad1[5] = {0.0, 2.0, 1.0, 3.0, 4.0};    // not monotone
+        long n_short[3] = {5, 1, 3};                    // too short axis
+        double* axes_bad[3] = {bad0, ax1, ax2};
+        if (sim5_interpnd_init(&ip, 3, n, axes_bad, data, NULL, 0, 0) != -1) failed++;
+        axes_bad[0] = bad1;
+        if (sim5_interpnd_init(&ip, 3, n, axes_bad, data, NULL, 0, 0) != -1) failed++;
+        if (sim5_interpnd_init(&ip, 3, n_short, axes, data, NULL, 0, 0) != -1) failed++;
+        if (sim5_interpnd_init(&ip, INTERP_ND_MAXDIM+1, n, axes, data, NULL, 0, 0) != -1) failed++;
+    }
+
+    printf("interpnd: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+void test__steffen()
+{
+    const int N = 20;
+    const int M = 2000;
+    int i, j, failed = 0;
+    double x[N], y[N];
+    sim5interp eager, lazy;
+
+    // step-like data: plateau, sharp step, plateau, steep ramp and a drop
+    for (i=0; i<N; i++) {
+        x[i] = (double)(i) + 0.3*sin((double)(i));
+        y[i] = (i < 6) ? 0.0 : (i < 12) ? 1.0 : (i < 16) ? 1.0 + 2.0*(i-11) : 0.5;
+    }
+
+    sim5_interp_init(&eager, x, y, N, INTERP_DATA_COPY, INTERP_TYPE_STEFFEN, 0);
+
+    // the same data pushed in one by one (starting with a small capacity, so that the arrays grow),
+    // the coefficients are made on the first evaluation
+    sim5_interp_init(&lazy, NULL, NULL, 4, INTERP_DATA_BUILD, INTERP_TYPE_STEFFEN, 0);
+    for (i=0; i<N; i++) sim5_interp_data_push(&lazy, x[i], y[i]);
+
+    // within each interval the interpolant is monotone and stays within the node values
+    for (j=0; j<N-1; j++) {
+        double ylo = fmin(y[j], y[j+1]);
+        double yhi = fmax(y[j], y[j+1]);
+        double yprev = y[j];
+        for (i=0; i<=M/N; i++) {
+            double xx = x[j] + (x[j+1]-x[j])*(double)(i)/(double)(M/N);
+            double yy = sim5_interp_eval(&eager, xx);
+            if ((yy < ylo-1e-14) || (yy > yhi+1e-14) || ((y[j+1]-y[j])*(yy-yprev) < -1e-14)) {
+                printf("steffen: overshoot or non-monotone value at x=%.6e (y=%.16e, nodes %.3e..%.3e)\n", xx, yy, y[j], y[j+1]);
+                failed++;
+                break;
+            }
+            if (yy != sim5_interp_eval(&lazy, xx)) {
+                printf("steffen: INTERP_DATA_BUILD differs from INTERP_DATA_COPY at x=%.6e\n", xx);
+                failed++;
+                break;
+            }
+            yprev = yy;
+        }
+    }
+
+    sim5_interp_done(&eager);
+    sim5_interp_done(&lazy);
+    printf("steffen: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+void test__disktable()
+{
+    const double a = 0.7;
+    const int M = 1000;
+    int i, j, l, failed = 0;
+    double R_in = r_ms(a);
+    double max_orth = 0.0, max_Omega = 0.0, max_g = 0.0;
+    sim5disktable t;
+
+    // Keplerian disk with a small radial drift (flat surface)
+    double flux(double R, void* ctx) { return pow(R, -3.); }
+    double ell(double R, void* ctx) { return ellK(R, *(double*)ctx); }
+    double vr(double R, void* ctx) { return -0.01; }
+
+    if (disktable_init(&t, a, R_in, 1000.0, 200, flux, ell, vr, NULL, (void*)&a) != 0) {
+        printf("disktable: FAILED (init)\n");
+        failures++;
+        return;
+    }
+
+    for (i=0; i<M; i++) {
+        double R = exp(log(R_in) + (log(1000.0)-log(R_in))*rnd);
+        double k_loc[4] = {1.0, 0.6, 0.0, 0.8};
+        double k[4];
+        sim5metric m;
+        sim5tetrad tt, te;
+
+        // interpolated tetrad must be orthonormal also between the nodes
+        disktable_tetrad(&t, R, &tt);
+        for (j=0; j<4; j++) for (l=0; l<4; l++) {
+            double eta = (j == l) ? ((j == 0) ? -1.0 : +1.0) : 0.0;
+            max_orth = fmax(max_orth, fabs(dotprod(tt.e[j], tt.e[l], &tt.metric) - eta));
+        }
+
+        // comparison to exact values
+        kerr_metric(a, R, 0.0, &m);
+        tetrad_surface(&m, OmegaK(R, a), -0.01, 0.0, &te);
+        on2bl(k_loc, k, &te);
+        max_Omega = fmax(max_Omega, fabs(disktable_Omega(&t, R)/OmegaK(R, a) - 1.0));
+        max_g = fmax(max_g, fabs(disktable_gfactor(&t, R, k)*dotprod(k, te.e[0], &m)/(m.g00*k[0]+m.g03*k[3]) - 1.0));
+    }
+
+    printf("disktable: orthonormality %.3e, Omega rel. error %.3e, g-factor rel. error %.3e\n", max_orth, max_Omega, max_g);
+    if ((max_orth > 1e-10) || (max_Omega > 1e-3) || (max_g > 1e-3)) failed++;
+
+    // invalid radii give NAN (zero flux), not a crash
+    {
+        double bad[3] = {NAN, 0.0, -1.0};
+        for (i=0; i<3; i++) {
+            double U[4];
+            disktable_fourvelocity(&t, bad[i], U);
+            if (!isnan(disktable_Omega(&t, bad[i])) || !isnan(U[0]) || (disktable_flux(&t, bad[i]) != 0.0)) {
+                printf("disktable: R=%e not rejected\n", bad[i]);
+                failed++;
+            }
+        }
+    }
+
+    disktable_done(&t);
+    printf("disktable: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__diskmodel()
+{
+    // test model library built by 'make test' from sim5unittests-diskmodel.c
+    char* lib = "bin/sim5unittests-diskmodel.so";
+    const int N = 100;
+    int i, n_open, failed = 0;
+    double R[N], y1[N], y2[N];
+    sim5diskmodel* copies[DISKMODEL_MAX_MODELS];
+
+    sim5diskmodel* m1 = sim5_diskmodel_open(lib, 10.0, 0.5, "k=1");
+    sim5diskmodel* m2 = sim5_diskmodel_open(lib, 10.0, 0.5, "k=2");
+    if ((!m1) || (!m2)) {
+        printf("diskmodel: FAILED (cannot open %s)\n", lib);
+        sim5_diskmodel_close(m1);
+        sim5_diskmodel_close(m2);
+        failures++;
+        return;
+    }
+
+    // the second copy lives in its own namespace and does not overwrite the parameter of the first one
+    if ((sim5_diskmodel_mdot(m1) != 1.0) || (sim5_diskmodel_mdot(m2) != 2.0)) {
+        printf("diskmodel: models share library state (mdot=%e, %e)\n", sim5_diskmodel_mdot(m1), sim5_diskmodel_mdot(m2));
+        failed++;
+    }
+    if ((sim5_diskmodel_get(m1->id) != m1) || (sim5_diskmodel_get(m2->id) != m2)) {
+        printf("diskmodel: registry lookup failed\n");
+        failed++;
+    }
+
+    // batch interface against scalar calls, and the cache against the library
+    for (i=0; i<N; i++) R[i] = 6.0 + 94.0*(double)(i)/(N-1);
+    sim5_diskmodel_eval_batch(m2, R, N, DISKMODEL_FLUX, y1);
+    for (i=0; i<N; i++) if (y1[i] != sim5_diskmodel_flux(m2, R[i])) {
+        printf("diskmodel: eval_batch differs at R=%e\n", R[i]);
+        failed++;
+        break;
+    }
+    sim5_diskmodel_cache(m2, 100.0, 1000);
+    sim5_diskmodel_eval_batch(m2, R, N, DISKMODEL_FLUX, y2);
+    for (i=0; i<N; i++) if (fabs(y2[i]/y1[i]-1.0) > 1e-3) {
+        printf("diskmodel: cached flux differs at R=%e (%e vs %e)\n", R[i], y2[i], y1[i]);
+        failed++;
+        break;
+    }
+
+    // further copies of the same library need a new link-map namespace each, which runs out
+    // before DISKMODEL_MAX_MODELS; opening must then fail cleanly
+    for (n_open=0; n_open<DISKMODEL_MAX_MODELS-2; n_open++) {
+        copies[n_open] = sim5_diskmodel_open(lib, 10.0, 0.5, "k=3");
+        if (!copies[n_open]) break;
+    }
+    printf("diskmodel: %d further copies of the library opened\n", n_open);
+    if (sim5_diskmodel_mdot(m1) != 1.0) failed++;
+    for (i=0; i<n_open; i++) sim5_diskmodel_close(copies[i]);
+
+    i = m1->id;
+    sim5_diskmodel_close(m1);
+    sim5_diskmodel_close(m2);
+    if (sim5_diskmodel_get(i) != NULL) failed++;
+
+    printf("diskmodel: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__arena()
+{
+    const int N = 50;
+    int i, k, failed = 0;
+    double x[N], y[N];
+    size_t total = 0;
+    sim5arena arena;
+
+    for (i=0; i<N; i++) {
+        x[i] = 1.0 + (double)(i);
+        y[i] = 1.0 + sqr(x[i]);
+    }
+
+    // reference interpolation with malloc
+    sim5interp ref;
+    sim5_interp_init(&ref, x, y, N, INTERP_DATA_COPY, INTERP_TYPE_LOGLOG, 0);
+
+    // small initial block, so that the first cycle overflows it
+    sim5_arena_init(&arena, 256);
+    if (arena.used != 0) failed++;
+
+    for (k=0; k<5; k++) {
+        sim5interp in;
+        sim5distrib d;
+        double gauss_pdf(double _x) { return exp(-sqr(_x)/2.); }
+
+        sim5_arena_set(&arena);
+        sim5_interp_init(&in, x, y, N, INTERP_DATA_COPY, INTERP_TYPE_LOGLOG, 0);
+        distrib_init(&d, gauss_pdf, -5.0, 5.0, 100);
+        double* arr = (double*)sim5_array_alloc(10, sizeof(double));
+        sim5_arena_set(NULL);
+        if ((in.arena != &arena) || (d.arena != &arena) || (!arr)) failed++;
+
+        // objects made from the arena work as those made with malloc
+        for (i=0; i<100; i++) {
+            double xx = 1.0 + 48.0*(double)(i)/99.0;
+            if (sim5_interp_eval(&in, xx) != sim5_interp_eval(&ref, xx)) { failed++; break; }
+        }
+        if (fabs(distrib_hit(&d)) > 5.0) failed++;
+
+        // raw allocations: alignment, in-place growth of the top allocation, LIFO free returns all space
+        size_t used = arena.used;
+        char* a = (char*)sim5_arena_malloc(&arena, 100);
+        char* b = (char*)sim5_arena_malloc(&arena, 30);
+        if ((((uintptr_t)a) % 16) || (((uintptr_t)b) % 16)) failed++;
+        memset(a, 1, 100);
+        memset(b, 2, 30);
+        if ((char*)sim5_arena_realloc(&arena, b, 60) != b) failed++;
+        sim5_arena_free(&arena, b);
+        sim5_arena_free(&arena, a);
+        if (arena.used != used) {
+            printf("arena: LIFO free leaves %zu bytes (expected %zu)\n", arena.used, used);
+            failed++;
+        }
+
+        // objects are finalized before the reset
+        sim5_array_free(arr);
+        distrib_done(&d);
+        sim5_interp_done(&in);
+        sim5_arena_reset(&arena);
+
+        // after the first reset the blocks are merged and the arena runs in a single block
+        if ((arena.used != 0) || (arena.retired != NULL)) failed++;
+        if ((k > 1) && (arena.total != total)) failed++;
+        total = arena.total;
+    }
+
+    printf("arena: steady-state block size %zu bytes\n", arena.total);
+    sim5_arena_done(&arena);
+    if ((arena.block != NULL) || (sim5_arena_current() != NULL)) failed++;
+    sim5_interp_done(&ref);
+
+    printf("arena: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__errors()
+{
+    const int N = 10;
+    double x[4] = {1.0, 2.0, 3.0, 4.0};
+    int i, failed = 0, printed = 0, suppressed = 0;
+    long count0 = sim5_error_count("sim5_interp_init");
+    long count_all0 = sim5_error_count(NULL);
+    long limit0 = sim5_error_log_limit(3);
+    char line[1024];
+    sim5interp in;
+
+    // capture stderr to count the printed messages
+    FILE* log = tmpfile();
+    int fd_stderr = dup(fileno(stderr));
+    fflush(stderr);
+    dup2(fileno(log), fileno(stderr));
+
+    sim5_error_clear();
+    // spline with extrapolation is refused (an error site that is not hit by other tests)
+    for (i=0; i<N; i++) sim5_interp_init(&in, x, x, 4, INTERP_DATA_REF, INTERP_TYPE_SPLINE, INTERP_OPT_CAN_EXTRAPOLATE);
+
+    fflush(stderr);
+    dup2(fd_stderr, fileno(stderr));
+    close(fd_stderr);
+    sim5_error_log_limit(limit0);
+
+    rewind(log);
+    while (fgets(line, sizeof(line), log)) {
+        if (strstr(line, "ERR (sim5_interp_init): spline")) printed++;
+        if (strstr(line, "further messages suppressed")) suppressed++;
+    }
+    fclose(log);
+
+    // last error of the thread, per-site counters and rate limiting of messages
+    if ((sim5_error_last() != SIM5_ERR_OPTION) || (!sim5_error_last_site()) || (strcmp(sim5_error_last_site(), "sim5_interp_init") != 0)) {
+        printf("errors: wrong last error (%d, %s)\n", sim5_error_last(), sim5_error_last_site());
+        failed++;
+    }
+    if ((sim5_error_count("sim5_interp_init") - count0 != N) || (sim5_error_count(NULL) - count_all0 != N)) {
+        printf("errors: wrong error count (%ld, %ld)\n", sim5_error_count("sim5_interp_init") - count0, sim5_error_count(NULL) - count_all0);
+        failed++;
+    }
+    if ((printed != 3) || (suppressed != 1)) {
+        printf("errors: %d messages printed, %d suppression notes (expected 3 and 1)\n", printed, suppressed);
+        failed++;
+    }
+    if ((in.N != 0) || !isnan(sim5_interp_eval(&in, 2.0))) failed++;
+
+    sim5_error_clear();
+    if ((sim5_error_last() != SIM5_OK) || (sim5_error_last_site() != NULL)) failed++;
+    if (strcmp(sim5_error_string(SIM5_ERR_OPTION), "unknown error") == 0) failed++;
+
+    printf("errors: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
+}
+
+
+
+void test__profile()
+{
+    int i, failed = 0;
+    long calls;
+    double G[4][4][4];
+    double x[3] = {1.0, 2.0, 3.0};
+    double xs[100];
+    sim5interp in;
+
+    if (!sim5_stats_enabled()) {
+        printf("profile: disabled (build with 'make test-profile' to test it)\n");
+        return;
+    }
+
+    sim5_stats_reset();
+    for (i=0; i<10; i++) kerr_connection(0.5, 5.0, 0.1, G);
+    sim5_interp_init(&in, x, x, 3, INTERP_DATA_REF, INTERP_TYPE_LINLIN, 0);
+    for (i=0; i<100; i++) xs[i] = 1.0 + 0.02*i;
+    sim5_interp_eval_batch(&in, xs, 100, xs);
+    sim5_interp_done(&in);
+
+    // counters and timers are summed over threads; only this thread has run since the reset
+    if (sim5_stats_counter(SIM5_STAT_CONNECTION) != 10) {
+        printf("profile: connection counter %ld (expected 10)\n", sim5_stats_counter(SIM5_STAT_CONNECTION));
+        failed++;
+    }
+    if ((sim5_stats_timer(SIM5_TIMER_INTERP_BATCH, &calls) <= 0.0) || (calls != 1)) {
+        printf("profile: batch interpolation timer has %ld calls (expected 1)\n", calls);
+        failed++;
+    }
+    if (sim5_stats_counter(-1) != 0) failed++;
+    sim5_stats_dump(stdout);
+
+    sim5_stats_reset();
+    if (sim5_stats_counter(SIM5_STAT_CONNECTION) != 0) failed++;
+
+    printf("profile: %s\n", failed ? "FAILED" : "OK");
+    if (failed) failures++;
 }
@@ -55,6 +55,144 @@ void error(const char *templatex, ...)
 
 
 
+#ifndef CUDA
+//! \cond SKIP
+static __thread int sim5error_code = SIM5_OK;
+static __thread const char* sim5error_site_name = NULL;
+static sim5error_site* sim5error_sites = NULL;
+static long sim5error_limit = 10;
+//! \endcond
+
+
+void sim5_error_raise(sim5error_site* site, int code, const char *templatex, ...)
+//! Reports an error.
+//! Use SIM5_ERROR() macro that provides a static error site for each place in the code.
+//! The error is recorded as the last error of the calling thread (see sim5_error_last()) and it is
+//! counted for its site (see sim5_error_count()). The message is printed to stderr only for the first 
+//! few errors of each site (see sim5_error_log_limit()), so errors in inner loops do not flood 
+//! the output. The routine never terminates the program.
+//!
+//! @param site error site (static variable that holds the counter)
+//! @param code error code (SIM5_ERR_xxx or SIM5_WRN_xxx)
+//! @param templatex printf-like message template followed by its arguments
+{
+    long n = __atomic_add_fetch(&site->count, 1, __ATOMIC_RELAXED);
+    long limit = __atomic_load_n(&sim5error_limit, __ATOMIC_RELAXED);
+    va_list ap;
+
+    sim5error_code = code;
+    sim5error_site_name = site->name;
+
+    // register the site on its first error (push to a lock-free list)
+    if (n == 1) {
+        sim5error_site* head = __atomic_load_n(&sim5error_sites, __ATOMIC_ACQUIRE);
+        do {
+            site->next = head;
+        } while (!__atomic_compare_exchange_n(&sim5error_sites, &head, site, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    }
+
+    if ((limit >= 0) && (n > limit)) return;
+
+    fprintf(stderr, "%s (%s): ", (code >= SIM5_WRN_EXTRAPOLATION) ? "WRN" : "ERR", site->name);
+    va_start(ap, templatex);
+    vfprintf(stderr, templatex, ap);
+    va_end(ap);
+    if ((limit >= 0) && (n == limit)) fprintf(stderr, " (further messages suppressed)");
+    fprintf(stderr, "\n");
+}
+
+
+int sim5_error_last()
+//! Last error of the calling thread.
+//!
+//! @result Code of the last error raised by the calling thread (SIM5_OK if none since sim5_error_clear()).
+{
+    return sim5error_code;
+}
+
+
+const char* sim5_error_last_site()
+//! Site of the last error of the calling thread.
+//!
+//! @result Name of the function that raised the last error in the calling thread (or NULL).
+{
+    return sim5error_site_name;
+}
+
+
+void sim5_error_clear()
+//! Clears the last error of the calling thread.
+{
+    sim5error_code = SIM5_OK;
+    sim5error_site_name = NULL;
+}
+
+
+const char* sim5_error_string(int code)
+//! Description of an error code.
+//!
+//! @param code error code
+//!
+//! @result Text description of the code.
+{
+    switch (code) {
+        case SIM5_OK:                   return "no error";
+        case SIM5_ERR_RANGE:            return "argument out of range";
+        case SIM5_ERR_GRID:             return "invalid data grid";
+        case SIM5_ERR_OPTION:           return "unsupported option";
+        case SIM5_ERR_NOT_IMPLEMENTED:  return "not implemented";
+        case SIM5_ERR_NOMEM:            return "memory allocation failure";
+        case SIM5_WRN_EXTRAPOLATION:    return "extrapolation";
+        case SIM5_WRN_ACCURACY:         return "accuracy not reached";
+        default:                        return "unknown error";
+    }
+}
+
+
+long sim5_error_count(const char* site)
+//! Number of errors.
+//! Gives the number of errors raised (by all threads) at given site, or at all sites.
+//!
+//! @param site name of the error site (function) or NULL for all sites
+//!
+//! @result Number of errors.
+{
+    long n = 0;
+    sim5error_site* s;
+    for (s = __atomic_load_n(&sim5error_sites, __ATOMIC_ACQUIRE); s; s = s->next) {
+        if ((!site) || (strcmp(site, s->name) == 0)) n += __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+
+long sim5_error_log_limit(long limit)
+//! Sets limit of printed error messages.
+//! Only the first `limit` errors of each error site are printed (10 by default).
+//!
+//! @param limit maximal number of messages per site (0 for no messages, negative for no limit)
+//!
+//! @result Previous limit.
+{
+    return __atomic_exchange_n(&sim5error_limit, limit, __ATOMIC_RELAXED);
+}
+
+
+void sim5_error_dump(FILE* file)
+//! Prints error statistics.
+//! Prints number of errors for each error site that has raised an error.
+//!
+//! @param file output stream
+{
+    sim5error_site* s;
+    for (s = __atomic_load_n(&sim5error_sites, __ATOMIC_ACQUIRE); s; s = s->next) {
+        fprintf(file, "%-40s %12ld\n", s->name, __atomic_load_n(&s->count, __ATOMIC_RELAXED));
+    }
+}
+#endif
+
+
+
 
 int sort_array_d_compare_func(const void *x, const void *y) {
     return (*(double*)x - *(double*)y);
@@ -80,16 +218,255 @@ void sort_array_f(float *array, int N)
 
 
 #ifndef CUDA
+//! \cond SKIP
+// arena memory layout:
+// - each block starts with a link to the previously filled-up block (SIM5ARENA_HEAD bytes),
+//   which is followed by the data area of `size` bytes, of which `used` bytes are taken
+// - each allocation is preceded by a header with the data-area offset where the allocation 
+//   starts (used to pop it off again) and with the size of the allocation (used by realloc)
+#define SIM5ARENA_ALIGN     16
+#define SIM5ARENA_HEAD      16
+#define SIM5ARENA_ROUND(s)  (((s)+SIM5ARENA_ALIGN-1) & ~(size_t)(SIM5ARENA_ALIGN-1))
+#define SIM5ARENA_DATA(a)   ((a)->block + SIM5ARENA_HEAD)
+
+typedef struct sim5arena_header {
+    size_t start;
+    size_t size;
+} sim5arena_header;
+
+static __thread sim5arena* sim5arena_current = NULL;
+
+
+static int sim5_arena_new_block(sim5arena* arena, size_t size)
+// retires current block and makes a new one with data area of given size 
+// (returns FALSE and leaves the arena unchanged if the allocation fails)
+{
+    char* block = (char*)malloc(SIM5ARENA_HEAD + size);
+    if (!block) return FALSE;
+    if (arena->block) arena->retired = arena->block;
+    *(void**)block = arena->retired;
+    arena->block = block;
+    arena->size  = size;
+    arena->used  = 0;
+    arena->total += size;
+    return TRUE;
+}
+//! \endcond
+
+
+void sim5_arena_init(sim5arena* arena, size_t size)
+//! Arena (bump) allocator initialization.
+//! Arena serves memory by advancing a pointer in a large preallocated block, which costs 
+//! no calls to the system allocator (and no locking in threaded programs). The memory is 
+//! released all at once by sim5_arena_reset(), e.g. after each ray or image tile.
+//! If the block gets full, a new one is added and the blocks are merged into a single 
+//! one on the next reset, so that steady state runs in a single block.
+//! Arena is not thread-safe, each thread should use its own arena.
+//! The number of bytes taken in the current block is kept in `arena->used` (zero for an empty arena).
+//! If the initial block cannot be allocated, the error is reported and the arena starts empty
+//! (the block is then allocated by the first sim5_arena_malloc()).
+//!
+//! @param arena arena object
+//! @param size initial size of the memory block [bytes]
+{
+    arena->block   = NULL;
+    arena->retired = NULL;
+    arena->size    = 0;
+    arena->used    = 0;
+    arena->total   = 0;
+    if (!sim5_arena_new_block(arena, SIM5ARENA_ROUND(size))) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_arena_init", "memory allocation failure (%zu bytes)", size);
+    }
+}
+
+
+void sim5_arena_done(sim5arena* arena)
+//! Arena finalization.
+//! Frees all memory of the arena.
+//!
+//! @param arena arena object
+{
+    void* b = arena->retired;
+    while (b) {
+        void* next = *(void**)b;
+        free(b);
+        b = next;
+    }
+    free(arena->block);
+    if (sim5arena_current == arena) sim5arena_current = NULL;
+    arena->block   = NULL;
+    arena->retired = NULL;
+    arena->size = arena->used = arena->total = 0;
+}
+
+
+void sim5_arena_reset(sim5arena* arena)
+//! Arena reset.
+//! Releases all allocations made from the arena at once. The memory is kept for further use.
+//! All objects that took memory from the arena must have been finalized by their done functions 
+//! (or abandoned) before the reset: the reset may free the blocks the allocations live in and 
+//! the same addresses are served again afterwards, so neither sim5_arena_free() nor sim5_arena_realloc() 
+//! may be called with a pointer obtained before the reset.
+//!
+//! @param arena arena object
+{
+    if (arena->retired) {
+        // merge blocks into a single one of the total size
+        // (if that cannot be allocated, the blocks are kept and only the current one is reused)
+        char* block = (char*)malloc(SIM5ARENA_HEAD + arena->total);
+        if (block) {
+            void* b = arena->retired;
+            while (b) {
+                void* next = *(void**)b;
+                free(b);
+                b = next;
+            }
+            free(arena->block);
+            *(void**)block = NULL;
+            arena->block   = block;
+            arena->retired = NULL;
+            arena->size    = arena->total;
+        }
+    }
+    arena->used = 0;
+}
+
+
+void* sim5_arena_malloc(sim5arena* arena, size_t size)
+//! Allocates memory from arena.
+//! The memory is aligned to 16 bytes. If `arena` is NULL, the memory is allocated by malloc().
+//!
+//! @param arena arena object (or NULL)
+//! @param size size of memory to allocate [bytes]
+//!
+//! @result Pointer to allocated memory or NULL if the memory cannot be allocated.
+{
+    if (!arena) return malloc(size);
+
+    size_t need = sizeof(sim5arena_header) + SIM5ARENA_ROUND(size);
+    if ((!arena->block) || (arena->used + need > arena->size)) {
+        size_t new_size = 2*arena->size;
+        if (new_size < need) new_size = need;
+        if (!sim5_arena_new_block(arena, new_size)) return NULL;
+    }
+
+    sim5arena_header* h = (sim5arena_header*)(SIM5ARENA_DATA(arena) + arena->used);
+    h->start = arena->used;
+    h->size  = size;
+    arena->used += need;
+    return (void*)(h+1);
+}
+
+
+void* sim5_arena_realloc(sim5arena* arena, void* ptr, size_t size)
+//! Reallocates memory from arena.
+//! If `ptr` is the last allocation of the arena, it is resized in place if possible, 
+//! otherwise a new memory is allocated and the content is copied (the old memory is then 
+//! released on arena reset). If `arena` is NULL, the memory is reallocated by realloc().
+//!
+//! @param arena arena object (or NULL)
+//! @param ptr pointer to previously allocated memory (or NULL)
+//! @param size new size of the memory [bytes]
+//!
+//! @result Pointer to reallocated memory or NULL if the memory cannot be allocated 
+//! (the original memory is then left untouched).
+{
+    if (!arena) return realloc(ptr, size);
+    if (!ptr) return sim5_arena_malloc(arena, size);
+
+    sim5arena_header* h = (sim5arena_header*)ptr - 1;
+    char* end = (char*)ptr + SIM5ARENA_ROUND(h->size);
+
+    // grow or shrink in place, if it is the top allocation
+    if ((end == SIM5ARENA_DATA(arena) + arena->used) && 
+        (h->start + sizeof(sim5arena_header) + SIM5ARENA_ROUND(size) <= arena->size)) {
+        arena->used = h->start + sizeof(sim5arena_header) + SIM5ARENA_ROUND(size);
+        h->size = size;
+        return ptr;
+    }
+
+    void* new_ptr = sim5_arena_malloc(arena, size);
+    if (!new_ptr) return NULL;
+    memcpy(new_ptr, ptr, (h->size < size) ? h->size : size);
+    return new_ptr;
+}
+
+
+void sim5_arena_free(sim5arena* arena, void* ptr)
+//! Frees memory allocated from arena.
+//! If `ptr` is the last allocation of the arena, the memory is returned to the arena 
+//! immediately, so buffers freed in reverse order of allocation (LIFO) give all their space back 
+//! and `arena->used` returns to its previous value. Otherwise (including allocations that live 
+//! in an older, filled-up block) the memory is released on arena reset. 
+//! The pointer must come from an allocation made after the last sim5_arena_reset().
+//! If `arena` is NULL, the memory is freed by free().
+//!
+//! @param arena arena object (or NULL)
+//! @param ptr pointer to previously allocated memory (or NULL)
+{
+    if (!arena) { free(ptr); return; }
+    if (!ptr) return;
+
+    sim5arena_header* h = (sim5arena_header*)ptr - 1;
+    if ((char*)ptr + SIM5ARENA_ROUND(h->size) == SIM5ARENA_DATA(arena) + arena->used) arena->used = h->start;
+}
+
+
+sim5arena* sim5_arena_set(sim5arena* arena)
+//! Sets current arena of the calling thread.
+//! While the current arena is set, the library takes memory for objects and temporary buffers 
+//! from it (interpolation objects, distributions, sim5_array) instead of using malloc(). 
+//! Objects created this way must be finalized by their done functions before the arena is reset
+//! (see sim5_arena_reset()); the done functions are cheap and they also free memory that cannot come from 
+//! the arena (coefficients made on evaluation of INTERP_DATA_BUILD interpolation). An object must not 
+//! be used, nor finalized, after the arena has been reset.
+//!
+//! @param arena arena object (or NULL to switch back to malloc)
+//!
+//! @result Previous current arena of the thread.
+{
+    sim5arena* prev = sim5arena_current;
+    sim5arena_current = arena;
+    return prev;
+}
+
+
+sim5arena* sim5_arena_current()
+//! Current arena of the calling thread.
+//!
+//! @result Current arena of the thread (set by sim5_arena_set()) or NULL.
+{
+    return sim5arena_current;
+}
+
+#undef SIM5ARENA_ALIGN
+#undef SIM5ARENA_HEAD
+#undef SIM5ARENA_ROUND
+#undef SIM5ARENA_DATA
+
+
+
 void* sim5_array_alloc(size_t capacity, size_t element_size)
 {
+    sim5arena* arena = sim5_arena_current();
+
     size_t size_total = element_size*capacity    // space allocated for elements
+                      + sizeof(sim5arena*)       // space for arena the memory comes from (or NULL)
                       + sizeof(size_t)           // space for info about size of stored elements 
                       + sizeof(size_t)           // space for info about allocated capacity
                       + sizeof(size_t);          // space for info about stored element count
     
-    void* ptr = malloc(size_total);
+    void* ptr = sim5_arena_malloc(arena, size_total);
+    if (!ptr) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_array_alloc", "memory allocation failure");
+        return NULL;
+    }
     memset(ptr, '\0', size_total);
 
+    // store arena
+    *(sim5arena**)(ptr) = arena;
+    ptr += sizeof(sim5arena*);
+
     // store element size    
     *(size_t*)(ptr) = element_size;
     ptr += sizeof(size_t);
@@ -108,8 +485,8 @@ void* sim5_array_alloc(size_t capacity, size_t element_size)
 
 void sim5_array_free(void* ptr)
 {
-    ptr -= 3*sizeof(size_t);
-    free(ptr);
+    ptr -= 3*sizeof(size_t) + sizeof(sim5arena*);
+    sim5_arena_free(*(sim5arena**)(ptr), ptr);
 }
 
 
@@ -118,18 +495,29 @@ void* sim5_array_realloc(void* array, size_t new_capacity)
     size_t* count = (size_t*)(array-1*sizeof(size_t));
     size_t* capa  = (size_t*)(array-2*sizeof(size_t));
     size_t* esize = (size_t*)(array-3*sizeof(size_t));
+    sim5arena* arena = *(sim5arena**)(array-3*sizeof(size_t)-sizeof(sim5arena*));
     
     size_t size_total = new_capacity * (*esize)    // space allocated for elements
+                      + sizeof(sim5arena*)         // space for arena the memory comes from (or NULL)
                       + sizeof(size_t)             // space for info about size of stored elements 
                       + sizeof(size_t)             // space for info about allocated capacity
                       + sizeof(size_t);            // space for info about stored element count
     
+    void* src_ptr = (array-3*sizeof(size_t)-sizeof(sim5arena*));
+    void* new_ptr = sim5_arena_realloc(arena, src_ptr, size_total);
+    if (!new_ptr) {
+        SIM5_ERROR(SIM5_ERR_NOMEM, "sim5_array_realloc", "memory allocation failure");
+        return NULL;
+    }
+
+    // the header has moved together with the data
+    array = new_ptr+3*sizeof(size_t)+sizeof(sim5arena*);
+    count = (size_t*)(array-1*sizeof(size_t));
+    capa  = (size_t*)(array-2*sizeof(size_t));
     (*capa)  = new_capacity;
     (*count) = fmin(*count, new_capacity);
 
-    void* src_ptr = (array-3*sizeof(size_t));
-    src_ptr = realloc(src_ptr, size_total);
-    return src_ptr+3*sizeof(size_t);
+    return array;
 }
 
 
@@ -10,11 +10,64 @@ void gprintf(FILE* file, const char *templatex, ...);
 void error(const char *templatex, ...);
 void warning(const char *templatex, ...);
 
+// error codes
+#define SIM5_OK                         0
+#define SIM5_ERR_RANGE                  1       // argument out of range
+#define SIM5_ERR_GRID                   2       // unordered or empty data grid
+#define SIM5_ERR_OPTION                 3       // unsupported option, type or data model
+#define SIM5_ERR_NOT_IMPLEMENTED        4       // case not implemented
+#define SIM5_ERR_NOMEM                  5       // memory allocation failure
+#define SIM5_WRN_EXTRAPOLATION          6       // extrapolation outside of data grid
+#define SIM5_WRN_ACCURACY               7       // requested accuracy not reached
+
+typedef struct sim5error_site {
+    const char* name;           // name of the error site (function)
+    long count;                 // number of errors raised at the site
+    struct sim5error_site* next;// next site in the list of sites that have raised an error
+} sim5error_site;
+
+#ifndef CUDA
+// reports an error: sets error code of the calling thread, counts the error for the site 
+// and prints the message if the limit of messages for the site has not been reached
+#define SIM5_ERROR(code, site, ...) do { \
+    static sim5error_site sim5error_site_ = {site, 0, NULL}; \
+    sim5_error_raise(&sim5error_site_, code, __VA_ARGS__); \
+} while (0)
+
+void sim5_error_raise(sim5error_site* site, int code, const char *templatex, ...);
+int  sim5_error_last();
+const char* sim5_error_last_site();
+void sim5_error_clear();
+const char* sim5_error_string(int code);
+long sim5_error_count(const char* site);
+long sim5_error_log_limit(long limit);
+void sim5_error_dump(FILE* file);
+#else
+#define SIM5_ERROR(code, site, ...) do {} while (0)
+#endif
+
 void sort_array(double *array, int N);
 void sort_array_f(float *array, int N);
 // sorts array of numbers
 
 #ifndef CUDA
+typedef struct sim5arena {
+    char*  block;               // current memory block
+    size_t size;                // size of the data area of the current block
+    size_t used;                // number of bytes used in the current block (0 if empty)
+    size_t total;               // total size of data areas of all blocks
+    void*  retired;             // list of filled-up blocks (they are freed on reset)
+} sim5arena;
+
+void sim5_arena_init(sim5arena* arena, size_t size);
+void sim5_arena_done(sim5arena* arena);
+void sim5_arena_reset(sim5arena* arena);
+void* sim5_arena_malloc(sim5arena* arena, size_t size);
+void* sim5_arena_realloc(sim5arena* arena, void* ptr, size_t size);
+void sim5_arena_free(sim5arena* arena, void* ptr);
+sim5arena* sim5_arena_set(sim5arena* arena);
+sim5arena* sim5_arena_current();
+
 void* sim5_array_alloc(size_t capacity, size_t element_size);
 void sim5_array_free(void* array);
 void* sim5_array_realloc(void* array, size_t new_capacity);